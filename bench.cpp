@@ -0,0 +1,582 @@
+// Maze storage benchmark: bit-packed MazeGrid against the old vector<Cell> layout.
+//
+//   bench [storage|views|gen|tiled|solve|particles|collide|rivals|all] [maxSize]
+//   bench suite [maxSize] [--json FILE] [--compare BASE.json] [--threshold PERCENT]
+//
+// storage: for each square size, memory, generation speed (same backtracker on
+//   both layouts), random wall lookups (what CircleFits does) and a full
+//   sweep over every cell's walls (what the wall-drawing loop does).
+// views: the backtracker through the fixed-size views against the runtime-sized one.
+// gen: cells/second of every MazeGenerator from 20x20 up to maxSize.
+// tiled: the tiled generator at maxSize with 1, 2, 4, ... threads; the maze hash
+//   must be the same on every line, and the maze must be perfect.
+// solve: DistanceField::Build (BFS from the exit) from 64x64 up to maxSize.
+// particles: ParticleField::Update per frame for 100 up to 100k particles.
+// collide: ResolveMoves for 1k up to 100k bodies in a 256x256 maze, moving up to
+//   0.9 cells per tick, with and without substeps; counts bodies that ended up
+//   on the far side of a wall.
+// rivals: FloodGame::Step on a 128x128 maze with 100 up to 100k AI rivals, on
+//   1, 2, 4, ... threads of the pool.
+// suite: the regression suite. ns per operation of the simulation hot paths
+//   (backtracker generation per cell, Player2D::CanMoveTo, index(), a
+//   WaterSystem::Update tick, a ParticleField::Update frame) at maze sizes
+//   from 20x20 up to maxSize, median of 5 runs. --json saves the results;
+//   --compare checks them against saved ones and exits 1 if any path got
+//   slower by more than the threshold (default 10%).
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include "maze.h"
+#include "mazegen.h"
+#include "solver.h"
+#include "particles.h"
+#include "collision.h"
+#include "sim.h"
+using namespace std;
+
+// The layout maze.h used before MazeGrid: 4 walls + visited per cell, shared walls stored twice
+class LegacyCell {
+public:
+	bool walls[4] = { true, true, true, true }; // top, bottom, left, right
+	bool visited = false;
+};
+
+class LegacyGrid {
+public:
+	int cols, rows;
+	vector<LegacyCell> cells;
+
+	LegacyGrid(int c, int r) : cols(c), rows(r), cells((size_t)c * r) {}
+
+	void FillWalls() {
+		for (auto& cell : cells) cell = LegacyCell();
+	}
+	bool Visited(int i) const { return cells[i].visited; }
+	void Visit(int i) { cells[i].visited = true; }
+	bool HasWall(int x, int y, int side) const { return cells[(size_t)y * cols + x].walls[side]; }
+	int WallBits(int x, int y) const {
+		const LegacyCell& cell = cells[(size_t)y * cols + x];
+		return cell.walls[WALL_RIGHT] | (cell.walls[WALL_BOTTOM] << 1);
+	}
+	void RemoveWall(int x, int y, int side) {
+		static const int opposite[4] = { WALL_BOTTOM, WALL_TOP, WALL_RIGHT, WALL_LEFT };
+		static const int dx[4] = { 0, 0, -1, 1 };
+		static const int dy[4] = { -1, 1, 0, 0 };
+		cells[(size_t)y * cols + x].walls[side] = false;
+		cells[(size_t)(y + dy[side]) * cols + x + dx[side]].walls[opposite[side]] = false;
+	}
+	size_t MemoryBytes() const { return cells.size() * sizeof(LegacyCell); }
+};
+
+class PackedGrid {
+public:
+	MazeGrid grid;
+	BitSet visited;
+
+	PackedGrid(int c, int r) : grid(c, r) {}
+
+	void FillWalls() {
+		grid.FillWalls();
+		visited.Resize((size_t)grid.cols * grid.rows);
+	}
+	bool Visited(int i) const { return visited.Test(i); }
+	void Visit(int i) { visited.Set(i); }
+	bool HasWall(int x, int y, int side) const { return grid.HasWall(x, y, side); }
+	int WallBits(int x, int y) const { return grid.WallBits(x, y); }
+	void RemoveWall(int x, int y, int side) { grid.RemoveWall(x, y, side); }
+	size_t MemoryBytes() const { return grid.MemoryBytes(); }
+};
+
+// Same DFS backtracker for both layouts so only the storage differs
+template <class Grid>
+void Generate(Grid& g, int cols, int rows) {
+	static const int dx[4] = { 0, 0, -1, 1 };
+	static const int dy[4] = { -1, 1, 0, 0 };
+	g.FillWalls();
+	vector<int> stack;
+	stack.push_back(0);
+	g.Visit(0);
+	while (!stack.empty()) {
+		int cur = stack.back();
+		int x = cur % cols, y = cur / cols;
+		int options[4], n = 0;
+		for (int side = 0; side < 4; side++) {
+			int nx = x + dx[side], ny = y + dy[side];
+			if (nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+			if (!g.Visited(nx + ny * cols)) options[n++] = side;
+		}
+		if (n == 0) {
+			stack.pop_back();
+			continue;
+		}
+		int side = options[rand() % n];
+		g.RemoveWall(x, y, side);
+		int next = (x + dx[side]) + (y + dy[side]) * cols;
+		g.Visit(next);
+		stack.push_back(next);
+	}
+}
+
+template <class Grid>
+void Run(const char* name, int size) {
+	srand(1);
+	Grid g(size, size);
+	double cells = (double)size * size;
+
+	auto t0 = chrono::steady_clock::now();
+	Generate(g, size, size);
+	auto t1 = chrono::steady_clock::now();
+
+	// Random point lookups
+	const int queries = 4000000;
+	uint32_t state = 12345, hits = 0;
+	for (int i = 0; i < queries; i++) {
+		state = state * 1664525u + 1013904223u;
+		int x = (state >> 8) % size;
+		state = state * 1664525u + 1013904223u;
+		int y = (state >> 8) % size;
+		hits += g.HasWall(x, y, (state >> 4) & 3);
+	}
+	auto t2 = chrono::steady_clock::now();
+
+	// Row-major sweep of the walls the renderer draws
+	uint64_t walls = 0;
+	for (int y = 0; y < size; y++)
+		for (int x = 0; x < size; x++)
+			walls += g.WallBits(x, y);
+	auto t3 = chrono::steady_clock::now();
+
+	double gen = chrono::duration<double>(t1 - t0).count();
+	double query = chrono::duration<double>(t2 - t1).count();
+	double sweep = chrono::duration<double>(t3 - t2).count();
+	cout << setw(7) << name << setw(6) << size
+		<< setw(12) << fixed << setprecision(2) << g.MemoryBytes() / 1048576.0 << " MB"
+		<< setw(10) << setprecision(1) << cells / gen / 1e6 << " Mcell/s gen"
+		<< setw(10) << queries / query / 1e6 << " Mq/s lookup"
+		<< setw(10) << cells / sweep / 1e6 << " Mcell/s sweep"
+		<< "  (" << hits % 10 + walls % 10 << ")\n";
+}
+
+// Repeats the backtracker on one grid, through WithMazeView (fixed) or the plain runtime view
+void RunViews(int size) {
+	MazeGrid grid(size, size);
+	BacktrackerGenerator generator;
+	int reps = max(1, 2000000 / (size * size));
+	double cells = (double)size * size * reps;
+
+	Rng rng(1);
+	auto t0 = chrono::steady_clock::now();
+	for (int i = 0; i < reps; i++) generator.Generate(grid, rng);
+	auto t1 = chrono::steady_clock::now();
+	for (int i = 0; i < reps; i++) generator.Run(static_cast<MazeView<MazeExtent>&>(grid), rng);
+	auto t2 = chrono::steady_clock::now();
+
+	cout << setw(6) << size << setw(10) << fixed << setprecision(1)
+		<< cells / chrono::duration<double>(t1 - t0).count() / 1e6 << " Mcell/s fixed"
+		<< setw(10) << cells / chrono::duration<double>(t2 - t1).count() / 1e6 << " Mcell/s runtime\n";
+}
+
+// Every generator at one size; small sizes are repeated so the timing is measurable
+void RunGenerators(int size) {
+	MazeGrid grid(size, size);
+	int reps = max(1, 4000000 / (size * size));
+	double cells = (double)size * size * reps;
+	cout << setw(6) << size;
+	for (int i = 0; i < (int)MazeAlgorithm::Count; i++) {
+		auto generator = MakeMazeGenerator((MazeAlgorithm)i);
+		Rng rng(1);
+		generator->Generate(grid, rng); // warm up, sizes the scratch buffers
+		auto t0 = chrono::steady_clock::now();
+		for (int r = 0; r < reps; r++) generator->Generate(grid, rng);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+		cout << setw(13) << fixed << setprecision(2) << cells / seconds / 1e6;
+	}
+	cout << "   Mcell/s" << endl;
+}
+
+// Open passages == cells - 1 and every cell reachable <=> perfect maze
+bool IsPerfect(const MazeGrid& grid) {
+	long long passages = 0;
+	for (int y = 0; y < grid.rows; y++)
+		for (int x = 0; x < grid.cols; x++)
+			passages += !grid.RightWall(x, y) + !grid.BottomWall(x, y);
+	if (passages != (long long)grid.CellCount() - 1) return false;
+
+	BitSet seen;
+	seen.Resize(grid.CellCount());
+	vector<int> stack = { 0 };
+	seen.Set(0);
+	int reached = 1;
+	while (!stack.empty()) {
+		int cell = stack.back();
+		stack.pop_back();
+		int x = cell % grid.cols, y = cell / grid.cols;
+		for (int side = 0; side < 4; side++) {
+			int n = grid.index(x + sideDX[side], y + sideDY[side]);
+			if (n != -1 && !grid.HasWall(x, y, side) && !seen.Test(n)) {
+				seen.Set(n);
+				stack.push_back(n);
+				reached++;
+			}
+		}
+	}
+	return reached == grid.CellCount();
+}
+
+void RunTiled(int size) {
+	MazeGrid grid(size, size);
+	TiledGenerator generator;
+	for (int threads = 1; threads <= max(8, DefaultThreadCount()); threads *= 2) {
+		generator.threads = threads;
+		Rng rng(1);
+		auto t0 = chrono::steady_clock::now();
+		generator.Generate(grid, rng);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+		uint64_t hash = 14695981039346656037ull;
+		for (uint64_t w : grid.storage) hash = (hash ^ w) * 1099511628211ull;
+		cout << setw(6) << size << setw(4) << threads << " threads"
+			<< setw(10) << fixed << setprecision(2) << (double)size * size / seconds / 1e6 << " Mcell/s"
+			<< "  hash " << hex << hash << dec
+			<< (IsPerfect(grid) ? "  perfect" : "  NOT PERFECT") << endl;
+	}
+}
+
+void RunSolve(int size) {
+	MazeGrid grid(size, size);
+	BacktrackerGenerator generator;
+	Rng rng(1);
+	generator.Generate(grid, rng);
+	DistanceField field;
+	field.Build(grid, size - 1, size - 1); // warm up, sizes the buffers
+
+	int reps = max(1, 16000000 / (size * size));
+	auto t0 = chrono::steady_clock::now();
+	for (int r = 0; r < reps; r++) WithMazeView(grid, [&](auto view) { field.Build(view, size - 1, size - 1); });
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count() / reps;
+	cout << setw(6) << size << setw(10) << fixed << setprecision(3) << seconds * 1000 << " ms"
+		<< setw(10) << setprecision(1) << (double)size * size / seconds / 1e6 << " Mcell/s"
+		<< "  farthest " << *max_element(field.dist.begin(), field.dist.end())
+		<< (field.Connected() ? "" : "  NOT CONNECTED") << endl;
+}
+
+void RunParticles(int count) {
+	ParticleField field;
+	field.Init(count, 1920, 1080, 1);
+	int frames = max(100, 20000000 / count);
+	auto t0 = chrono::steady_clock::now();
+	for (int f = 0; f < frames; f++) field.Update();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count() / frames;
+	cout << setw(8) << count << setw(10) << fixed << setprecision(2) << seconds * 1e6 << " us/frame"
+		<< setw(8) << setprecision(2) << seconds * 1e9 / count << " ns/particle" << endl;
+}
+
+void RunCollide(int count, bool substeps) {
+	const int size = 256, cellSize = 20;
+	MazeGrid grid(size, size);
+	KruskalGenerator generator;
+	Rng rng(1);
+	generator.Generate(grid, rng);
+
+	BodyBatch bodies;
+	for (int i = 0; i < count; i++) {
+		bodies.Add((rng.Below(size) + 0.5f) * cellSize, (rng.Below(size) + 0.5f) * cellSize, cellSize * 0.3f);
+	}
+	vector<float> lastX, lastY;
+	const int ticks = max(20, 2000000 / count);
+	long long crossings = 0;
+	double seconds = 0;
+	for (int t = 0; t < ticks; t++) {
+		for (int i = 0; i < count; i++) {
+			bodies.moveX[i] = ((int)rng.Below(37) - 18) * 0.05f * cellSize;
+			bodies.moveY[i] = ((int)rng.Below(37) - 18) * 0.05f * cellSize;
+		}
+		lastX = bodies.x;
+		lastY = bodies.y;
+		auto t0 = chrono::steady_clock::now();
+		ResolveMoves(grid, cellSize, bodies, substeps ? cellSize * 0.25f : 1e9f, DefaultThreadCount());
+		seconds += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+		// Moves are under a cell, so a body can only have stepped into a neighbour
+		// through an open wall, or a diagonal one around an open corner
+		for (int i = 0; i < count; i++) {
+			int ax = (int)(lastX[i] / cellSize), ay = (int)(lastY[i] / cellSize);
+			int bx = (int)(bodies.x[i] / cellSize), by = (int)(bodies.y[i] / cellSize);
+			int sx = bx > ax ? WALL_RIGHT : WALL_LEFT, sy = by > ay ? WALL_BOTTOM : WALL_TOP;
+			bool ok;
+			if (ay == by) ok = ax == bx || !grid.HasWall(ax, ay, sx);
+			else if (ax == bx) ok = !grid.HasWall(ax, ay, sy);
+			else ok = (!grid.HasWall(ax, ay, sx) && !grid.HasWall(bx, ay, sy))
+				|| (!grid.HasWall(ax, ay, sy) && !grid.HasWall(ax, by, sx));
+			crossings += !ok;
+		}
+	}
+	cout << setw(8) << count << (substeps ? "  substeps" : "  one step") << setw(10) << fixed << setprecision(1)
+		<< seconds / ticks * 1e6 << " us/tick" << setw(8) << setprecision(1) << seconds / ticks / count * 1e9
+		<< " ns/body" << setw(8) << crossings << " through walls" << endl;
+}
+
+void RunRivals(int count, int threads) {
+	FloodGame game;
+	game.config.width = game.config.height = 128;
+	game.rivalCount = count;
+	game.threads = threads;
+	game.NewGame(1); // the maze only depends on the seed, so every line plays the same one
+
+	const int ticks = 600;
+	auto t0 = chrono::steady_clock::now();
+	for (int t = 0; t < ticks; t++) game.Step(0);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+	cout << setw(8) << count << " rivals" << setw(3) << threads << " threads" << setw(10) << fixed << setprecision(1)
+		<< seconds / ticks * 1e6 << " us/tick" << setw(8) << setprecision(1) << seconds / ticks / count * 1e9
+		<< " ns/rival  racing " << game.rivals.racing << " out " << game.rivals.escaped
+		<< " drowned " << game.rivals.drowned << endl;
+}
+
+// One line of the regression suite
+struct SuiteResult {
+	string name;
+	int size;
+	double ns;  // per operation, lower is better
+};
+
+// Median over a few runs of the ns per operation of run(), which does `ops` of
+// them. setup() goes before every run and isn't timed.
+template <class Setup, class F>
+double MedianNs(double ops, Setup setup, F run) {
+	const int RUNS = 5;
+	double ns[RUNS];
+	for (int r = 0; r < RUNS; r++) {
+		setup();
+		auto t0 = chrono::steady_clock::now();
+		run();
+		ns[r] = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / ops;
+	}
+	sort(ns, ns + RUNS);
+	return ns[RUNS / 2];
+}
+
+template <class F>
+double MedianNs(double ops, F run) {
+	return MedianNs(ops, [] {}, run);
+}
+
+vector<SuiteResult> RunSuite(int maxSize) {
+	vector<SuiteResult> results;
+	auto add = [&](const string& name, int size, double ns) {
+		results.push_back({ name, size, ns });
+		cout << setw(18) << left << name << right << setw(6) << size << setw(12) << fixed << setprecision(2) << ns << " ns" << endl;
+	};
+	uint64_t sink = 0; // keeps the measured work from being optimised away
+
+	for (int size = 20; size <= maxSize; size = size < 64 ? size == 20 ? 64 : 256 : size * 4) {
+		MazeGrid grid(size, size);
+		MazeConfig config;
+		config.width = config.height = size;
+		double cells = (double)size * size;
+
+		// The original maze_generation, per cell; small mazes are repeated to be measurable
+		BacktrackerGenerator generator;
+		Rng rng(1);
+		int reps = max(1, 1000000 / (size * size));
+		add("generate", size, MedianNs(cells * reps, [&] {
+			for (int r = 0; r < reps; r++) generator.Generate(grid, rng);
+		}));
+
+		// Random probes, as the player's collision makes them
+		const int probes = 1000000;
+		vector<float> px(probes), py(probes);
+		for (int i = 0; i < probes; i++) {
+			px[i] = rng.Below(size * config.cellSize);
+			py[i] = rng.Below(size * config.cellSize);
+		}
+		Player2D player;
+		player.Reset(config);
+		add("canmove", size, MedianNs(probes, [&] {
+			WithMazeView(grid, [&](auto view) {
+				for (int i = 0; i < probes; i++) sink += player.CanMoveTo(px[i], py[i], view);
+			});
+		}));
+
+		add("index", size, MedianNs(probes, [&] {
+			for (int i = 0; i < probes; i++) sink += grid.index((int)px[i] / config.cellSize, (int)py[i] / config.cellSize + (i & 1));
+		}));
+
+		// Ten seconds of rising water, per tick, the player standing at the start.
+		// Every run starts from a copy of the same fresh water; Reset() costs far
+		// more than the ticks on big mazes and isn't what this tracks.
+		WaterSystem fresh, water;
+		Rng waterRng(1, RNG_WATER);
+		fresh.Reset(config, waterRng);
+		const int ticks = TICK_RATE * 10;
+		add("water.update", size, MedianNs(ticks, [&] { water = fresh; }, [&] {
+			WithMazeView(grid, [&](auto view) {
+				for (int t = 0; t < ticks; t++) water.Update(view, player.x, player.y, TICK_DT);
+			});
+			sink += water.flood.filled.size();
+		}));
+	}
+
+	// Particles don't depend on the maze; one frame of each count
+	for (int count : { 100, 10000 }) {
+		ParticleField field;
+		field.Init(count, 1920, 1080, 1);
+		const int frames = max(100, 2000000 / count);
+		add("particles.update", count, MedianNs(frames, [&] {
+			for (int f = 0; f < frames; f++) field.Update();
+		}));
+		sink += (uint64_t)field.x[0];
+	}
+	volatile uint64_t keep = sink;
+	(void)keep;
+	return results;
+}
+
+bool SaveSuite(const vector<SuiteResult>& results, const string& path) {
+	FILE* f = fopen(path.c_str(), "w");
+	if (!f) return false;
+	fprintf(f, "{\"version\": 1, \"results\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		fprintf(f, "  {\"name\": \"%s\", \"size\": %d, \"ns\": %.4f}%s\n", results[i].name.c_str(),
+			results[i].size, results[i].ns, i + 1 < results.size() ? "," : "");
+	}
+	fprintf(f, "]}\n");
+	return fclose(f) == 0;
+}
+
+// Reads back what SaveSuite() writes: one result object per line. False if
+// there's nothing to read, so a broken baseline can't pass as no regressions.
+bool LoadSuite(const string& path, vector<SuiteResult>& results) {
+	ifstream in(path);
+	if (!in) return false;
+	for (string line; getline(in, line);) {
+		char name[64];
+		int size;
+		double ns;
+		if (sscanf(line.c_str(), " {\"name\": \"%63[^\"]\", \"size\": %d, \"ns\": %lf", name, &size, &ns) == 3) {
+			results.push_back({ name, size, ns });
+		}
+	}
+	return !results.empty();
+}
+
+// Returns how many paths regressed past the threshold; `missing` counts the
+// paths only one of the two runs has
+int CompareSuite(const vector<SuiteResult>& now, const vector<SuiteResult>& base, double threshold, int& missing) {
+	int regressed = 0;
+	missing = 0;
+	auto find = [](const vector<SuiteResult>& in, const SuiteResult& r) {
+		return find_if(in.begin(), in.end(), [&](const SuiteResult& b) { return b.name == r.name && b.size == r.size; });
+	};
+	cout << "\n" << setw(18) << left << "path" << right << setw(6) << "size" << setw(12) << "base ns"
+		<< setw(12) << "now ns" << setw(10) << "change" << "\n";
+	for (const SuiteResult& r : now) {
+		auto match = find(base, r);
+		if (match == base.end()) {
+			missing++;
+			cout << setw(18) << left << r.name << right << setw(6) << r.size << "  not in the baseline\n";
+			continue;
+		}
+		double change = r.ns / match->ns - 1;
+		bool bad = change > threshold;
+		regressed += bad;
+		cout << setw(18) << left << r.name << right << setw(6) << r.size << setw(12) << fixed << setprecision(2) << match->ns
+			<< setw(12) << r.ns << setw(9) << setprecision(1) << showpos << change * 100 << "%" << noshowpos
+			<< (bad ? "  REGRESSED" : "") << "\n";
+	}
+	for (const SuiteResult& b : base) {
+		if (find(now, b) != now.end()) continue;
+		missing++;
+		cout << setw(18) << left << b.name << right << setw(6) << b.size << "  not run this time\n";
+	}
+	return regressed;
+}
+
+int main(int argc, char** argv) {
+	// Options for the suite, then the positional arguments
+	string jsonPath, comparePath;
+	double threshold = 0.10;
+	vector<char*> args;
+	for (int i = 0; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+		else if (arg == "--compare" && i + 1 < argc) comparePath = argv[++i];
+		else if (arg == "--threshold" && i + 1 < argc) threshold = atof(argv[++i]) / 100;
+		else args.push_back(argv[i]);
+	}
+	argc = (int)args.size();
+	argv = args.data();
+
+	string section = argc > 1 ? argv[1] : "all";
+	int maxSize = argc > 2 ? atoi(argv[2]) : 4096;
+
+	if (section == "suite") {
+		vector<SuiteResult> results = RunSuite(maxSize);
+		if (!jsonPath.empty() && !SaveSuite(results, jsonPath)) {
+			cerr << "can't write " << jsonPath << "\n";
+			return 1;
+		}
+		if (comparePath.empty()) return 0;
+		vector<SuiteResult> base;
+		if (!LoadSuite(comparePath, base)) {
+			cerr << "can't read a suite baseline from " << comparePath << "\n";
+			return 1;
+		}
+		int missing;
+		int regressed = CompareSuite(results, base, threshold, missing);
+		cout << (regressed ? to_string(regressed) + " paths regressed" : "no regressions")
+			<< " (threshold " << threshold * 100 << "%)";
+		if (missing) cout << ", " << missing << " paths in only one run";
+		cout << "\n";
+		return regressed || missing ? 1 : 0;
+	}
+
+	if (section == "storage" || section == "all") {
+		for (int size = 20; size <= maxSize; size = size < 64 ? 64 : size * 4) {
+			Run<LegacyGrid>("cells", size);
+			Run<PackedGrid>("packed", size);
+		}
+		cout << "\n";
+	}
+	if (section == "views" || section == "all") {
+		for (int size : { 20, 32, 64, 128 }) RunViews(size);
+		cout << "\n";
+	}
+	if (section == "gen" || section == "all") {
+		cout << "  size";
+		for (int i = 0; i < (int)MazeAlgorithm::Count; i++) cout << setw(13) << MazeAlgorithmName((MazeAlgorithm)i);
+		cout << "\n";
+		for (int size = 20; size <= maxSize; size = size < 32 ? 32 : size * 2) RunGenerators(size);
+		cout << "\n";
+	}
+	if (section == "tiled" || section == "all") {
+		RunTiled(maxSize);
+		cout << "\n";
+	}
+	if (section == "solve" || section == "all") {
+		for (int size = 64; size <= maxSize; size *= 2) RunSolve(size);
+		cout << "\n";
+	}
+	if (section == "particles" || section == "all") {
+		for (int count : { 100, 1000, 10000, 100000 }) RunParticles(count);
+		cout << "\n";
+	}
+	if (section == "collide" || section == "all") {
+		for (int count : { 1000, 10000, 100000 }) {
+			RunCollide(count, false);
+			RunCollide(count, true);
+		}
+		cout << "\n";
+	}
+	if (section == "rivals" || section == "all") {
+		for (int count : { 100, 1000, 10000, 100000 }) RunRivals(count, DefaultThreadCount());
+		for (int threads = 1; threads <= max(4, DefaultThreadCount()); threads *= 2) RunRivals(10000, threads);
+	}
+	return 0;
+}
@@ -5,13 +5,18 @@
 #include <cstdlib>
 #include <ctime>
 #include <string>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
 #include <raylib.h>
+#include "sim.h"
+#include "mazequeue.h"
+#include "endless.h"
+#include "particles.h"
+#include "profiler.h"
 using namespace std;
 
-const int width = 20;
-const int height = 20;
-const int CELL_SIZE = 20;
-
 Color purpleTop = { 60, 20, 90, 255 };
 Color blackBottom = { 8, 8, 12, 255 };
 Color textMain = { 180, 160, 200, 255 };
@@ -20,564 +25,966 @@ Color barBg = { 25, 20, 35, 255 };
 Color barFill = { 120, 60, 180, 255 };
 Color barBorder = { 90, 70, 130, 255 };
 
-class Cell {
-public:
-	bool walls[4] = { true, true, true, true }; // top, bottom, left, right
-	bool visited = false;
-};
+// Rendering for the simulation types in sim.h
 
-class WaterSystem {
-public:
-	float waterLevel = 0.0f;  // Current water height in pixels
-	float riseSpeed = 0.3f;   // Pixels per frame
-	float maxWaterLevel;
-	float oxygenLevel = 100.0f;
-	float oxygenDepletionRate = 0.15f;
-	bool isPlayerUnderwater = false;
-
-	struct AirBubble {
-		float x, y;
-		bool collected;
-	};
+// The cells a frame shows, [x0, x1) x [y0, y1), already clamped to the maze
+struct CellRect {
+	int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
 
-	struct DrainSwitch {
-		float x, y;
-		bool activated;
-		float activationRadius = 20.0f; // How close player must be to activate
-	};
+	bool Contains(float px, float py, int cellSize) const {
+		return px >= x0 * cellSize && px < x1 * cellSize && py >= y0 * cellSize && py < y1 * cellSize;
+	}
+};
 
-	vector<AirBubble> airBubbles;
-	vector<DrainSwitch> drainSwitches;
-	float waveOffset = 0;
-
-	WaterSystem() {
-		maxWaterLevel = height * CELL_SIZE;
-		Reset();
-	}
-
-	void Reset() { // This is when starting new game to reset everything. 
-		waterLevel = 0.0f;
-		oxygenLevel = 100.0f;
-		isPlayerUnderwater = false;
-		airBubbles.clear();
-		drainSwitches.clear();
-
-		// Placing 8 air bubbles randomly in maze
-		for (int i = 0; i < 8; i++) {
-			AirBubble bubble;
-			bubble.x = (rand() % width) * CELL_SIZE + CELL_SIZE / 2;
-			bubble.y = (rand() % height) * CELL_SIZE + CELL_SIZE / 2;
-			bubble.collected = false;
-			airBubbles.push_back(bubble);
+void DrawWater(const WaterSystem& water, float alpha, const CellRect& visible) {
+	// Draw the water in view only, a row at a time: runs of full cells go out as
+	// one rectangle, so a flooded screen is a rectangle per row. The frontier is
+	// drawn between ticks.
+	ProfileScope zone(PROFILE_WATER_DRAW);
+	const FloodField& flood = water.flood;
+	const int cellSize = water.cellSize;
+	Color waterColor = { 30, 60, 150, 160 };
+	for (int y = visible.y0; y < visible.y1; y++) {
+		for (int x = visible.x0; x < visible.x1;) {
+			int cell = x + y * flood.cols;
+			if (flood.depth[cell] == 0) {
+				x++;
+				continue;
+			}
+			if (flood.depth[cell] == FloodField::FULL && !flood.inFrontier.Test(cell)) {
+				int end = x + 1;
+				while (end < visible.x1 && flood.depth[cell + end - x] == FloodField::FULL
+					&& !flood.inFrontier.Test(cell + end - x)) end++;
+				DrawRectangle(x * cellSize, y * cellSize, (end - x) * cellSize, cellSize, waterColor);
+				zone.Draws(1);
+				x = end;
+				continue;
+			}
+			int height = (int)(flood.DrawDepth(cell, alpha) * cellSize / FloodField::FULL);
+			if (height > 0) {
+				DrawRectangle(x * cellSize, (y + 1) * cellSize - height, cellSize, height, waterColor);
+				zone.Draws(1);
+			}
+			x++;
 		}
+	}
 
-		// Placing 3 drain switches at strategic locations
-		DrainSwitch drain1 = {
-			CELL_SIZE*2.5f,
-			CELL_SIZE*2.5f,
-			false
-		};
-		DrainSwitch drain2 = {
-			CELL_SIZE * (width - 2.5f),
-			CELL_SIZE * (height - 2.5f),
-			false
-		};
-		DrainSwitch drain3 = {
-			CELL_SIZE * (width / 2),
-			CELL_SIZE * (height / 2),
-			false
-		};
+	// Spots a cell outside the view can still reach in with their glow and label
+	int x0 = max(visible.x0 - 1, 0), y0 = max(visible.y0 - 1, 0);
+	int x1 = min(visible.x1 + 1, flood.cols), y1 = min(visible.y1 + 1, flood.rows);
+
+	// Draw air bubbles
+	water.bubbleIndex.ForEachIn(x0, y0, x1, y1, [&](int i) {
+		auto& bubble = water.airBubbles[i];
+		DrawCircleGradient(bubble.x, bubble.y, 12, { 200, 200, 255, 200 }, { 100, 100, 200, 100 });
+		DrawCircle(bubble.x - 3, bubble.y - 3, 3, { 255, 255, 255, 255 });
+		zone.Draws(2);
+	});
+
+	// Draw drain switches; a handful, and switched on ones aren't in drainIndex
+	for (auto& drain : water.drainSwitches) {
+		int x = (int)(drain.x / cellSize), y = (int)(drain.y / cellSize);
+		if (x < x0 || x >= x1 || y < y0 || y >= y1) continue;
+		Color switchColor = drain.activated ? GREEN : RED;
+		Color glowColor = drain.activated ? Color{ 0, 255, 0, 50 } : Color{ 255, 0, 0, 50 };
+
+		// Glow effect also Labeling an also swith bogy
+		DrawCircle(drain.x, drain.y, drain.activationRadius, glowColor);
+
+		DrawCircle(drain.x, drain.y, 12, BLACK);
+		DrawCircle(drain.x, drain.y, 10, switchColor);
+
+		
+		const char* text = drain.activated ? "ON" : "OFF";
+		DrawText(text, drain.x - 10, drain.y - 25, 10, switchColor);
+		zone.Draws(4);
+	}
+}
 
-		drainSwitches.push_back(drain1);
-		drainSwitches.push_back(drain2);
-		drainSwitches.push_back(drain3);
+void DrawWaterUI(const WaterSystem& water, int screenW, int screenH) {
+	ProfileScope zone(PROFILE_WATER_UI);
+	zone.Draws(5 + (uint32_t)water.drainSwitches.size() * 2);
+	// Water level indicator
+	int indicatorX = 10;
+	int indicatorY = 120;
+	DrawRectangle(indicatorX, indicatorY, 30, 200, Fade(BLACK, 0.5f));
+	DrawRectangle(indicatorX, indicatorY + 200 - water.GetWaterPercentage() * 2,30, water.GetWaterPercentage() * 2, Fade(BLUE, 0.7f));
+	DrawRectangleLines(indicatorX, indicatorY, 30, 200, WHITE);
+	DrawText("WATER", indicatorX - 5, indicatorY - 20, 16, BLUE);
+
+	// Oxygen bar (only whn prson is underwater or low oxygen)
+	if (water.isPlayerUnderwater || water.oxygenLevel < 100) {
+		int barX = screenW / 2 - 150;
+		int barY = 80;
+
+		// Background
+		DrawRectangle(barX - 2, barY - 2, 304, 24, BLACK);
+		zone.Draws(4);
+		
+		// Oxygen bar
+		Color oxyColor;
+		if (water.oxygenLevel > 60) oxyColor = SKYBLUE;
+		else if (water.oxygenLevel > 30) oxyColor = YELLOW;
+		else oxyColor = RED;
+
+		DrawRectangle(barX, barY, (int)(300 * water.oxygenLevel / 100), 20, oxyColor);
+		DrawRectangleLines(barX, barY, 300, 20, WHITE);
+		// Text
+		DrawText("OXYGEN", barX + 120, barY + 2, 16, WHITE);
+		// Critical warning
+		if (water.oxygenLevel < 30) {
+			if ((int)(GetTime() * 3) % 2 == 0) {
+				DrawText("WARNING: LOW OXYGEN!",
+					screenW / 2 - MeasureText("WARNING: LOW OXYGEN!", 20) / 2,
+					barY + 30, 20, RED);
+			}
+		}
 	}
 
-	void Update(float playerX, float playerY, float deltaTime) { 
-		waveOffset += deltaTime * 50; 
-		if (waveOffset > 360) waveOffset -= 360;
+	// Drain status
+	int drainY = 350;
+	DrawText("DRAIN SWITCHES:", 10, drainY, 14, WHITE);
+	for (int i = 0; i < water.drainSwitches.size(); i++) {
+		Color statusColor = water.drainSwitches[i].activated ? GREEN : RED;
+		DrawCircle(25 + i * 40, drainY + 27, 10, statusColor);
+		DrawText(TextFormat("%d", i + 1), 22 + i * 40, drainY + 22, 12, WHITE);
+	}
+}
 
-		// Count active drains
-		int activeDrains = 0;
-		for (auto drain : drainSwitches) {
-			if (drain.activated) activeDrains++;
-		}
+void DrawPlayer(const Player2D& player, float alpha, int offsetX, int offsetY, bool isUnderwater) {
+	Color playerColor = isUnderwater ? Color{ 100, 150, 255, 255 } : Color{ 255, 200, 100, 255 };
+	float x = player.DrawX(alpha), y = player.DrawY(alpha);
 
-		// Adjust water level based on drains
-		if (activeDrains == 0) {
-			waterLevel += riseSpeed;
-		}
-		else if (activeDrains == 1) {
-			waterLevel += riseSpeed * 0.3f; // Slower rise
-		}
-		else if (activeDrains == 2) {
-			waterLevel -= riseSpeed * 0.2f; // Slowly drains
-		}
-		else {
-			waterLevel -= riseSpeed * 1.5f; // Fast drain with all switches
+	// Draw player
+	DrawCircle(offsetX + x, offsetY + y, player.size / 2, playerColor);
+	DrawCircleLines(offsetX + x, offsetY + y, player.size / 2, BLACK);
+
+	// Draw bubble effect if underwater
+	if (isUnderwater) {
+		for (int i = 0; i < 3; i++) {
+			float bubbleY = y - 10 - i * 5 - sin(GetTime() * 3) * 3;
+			DrawCircle(offsetX + x, offsetY + bubbleY, 2 - i * 0.5f,
+				Fade(WHITE, 0.5f - i * 0.1f));
 		}
+	}
+}
 
-		// Clamp water level --> Limiting the water level within bounds
-		if (waterLevel < 0) waterLevel = 0;
-		if (waterLevel > maxWaterLevel) waterLevel = maxWaterLevel;
+// Rivals still racing, coloured by their oxygen; the ones that drowned stay as faded dots
+void DrawRivals(const RivalSwarm& rivals, float alpha, const CellRect& visible, int cellSize) {
+	for (int i = 0; i < rivals.count; i++) {
+		if (rivals.state[i] == RIVAL_ESCAPED || !visible.Contains(rivals.bodies.x[i], rivals.bodies.y[i], cellSize)) continue;
+		Color c;
+		if (rivals.state[i] == RIVAL_DROWNED) c = Fade(GRAY, 0.3f);
+		else if (rivals.oxygen[i] > 60) c = Color{ 255, 120, 180, 255 };
+		else if (rivals.oxygen[i] > 30) c = YELLOW;
+		else c = RED;
+		float x = rivals.prevX[i] + (rivals.bodies.x[i] - rivals.prevX[i]) * alpha;
+		float y = rivals.prevY[i] + (rivals.bodies.y[i] - rivals.prevY[i]) * alpha;
+		DrawCircle(x, y, rivals.bodies.radius[i], c);
+	}
+}
 
-		// Check if player is underwater
-		float waterTopY = maxWaterLevel - waterLevel;
-		isPlayerUnderwater = (playerY > waterTopY); // Why not directly compare with waterLevel? why not playerY > waterLevel?
+// Hint: a few steps of the shortest route from the player's cell, with an arrow head
+void DrawHint(const Player2D& player, float alpha, const DistanceField& solver, int offsetX, int offsetY) {
+	const int cellSize = player.cellSize;
+	int x = (int)(player.x / cellSize);
+	int y = (int)(player.y / cellSize);
+	Vector2 from = { offsetX + player.DrawX(alpha), offsetY + player.DrawY(alpha) };
+	Color hintColor = Fade(YELLOW, 0.7f);
+
+	int side = -1;
+	for (int i = 0; i < 4; i++) {
+		int next = solver.NextStep(x, y);
+		if (next < 0) break;
+		side = next;
+		x += sideDX[side];
+		y += sideDY[side];
+		Vector2 to = { offsetX + (x + 0.5f) * cellSize, offsetY + (y + 0.5f) * cellSize };
+		DrawLineEx(from, to, 2.0f, hintColor);
+		from = to;
+	}
+	if (side < 0) return;
+
+	// Arrow head pointing along the last step; tip, left, right is counter-clockwise on screen
+	float dx = (float)sideDX[side], dy = (float)sideDY[side];
+	float head = cellSize * 0.35f;
+	Vector2 tip = { from.x + dx * head, from.y + dy * head };
+	Vector2 left = { from.x + dy * head * 0.6f, from.y - dx * head * 0.6f };
+	Vector2 right = { from.x - dy * head * 0.6f, from.y + dx * head * 0.6f };
+	DrawTriangle(tip, left, right, hintColor);
+}
+
+// Camera for the flood game: follows the player, zoomed with the mouse wheel
+// or + / -. Along an axis where the whole maze fits on screen it stays centred
+// instead, which is how small mazes always looked.
+class FollowCamera {
+public:
+	static constexpr float MAX_ZOOM = 4.0f;
+	Camera2D camera = { { 0, 0 }, { 0, 0 }, 0.0f, 1.0f };
+	float zoom = 1.0f;
+
+	void Update(float targetX, float targetY, const FloodGame& game, int screenW, int screenH) {
+		const int cellSize = game.config.cellSize;
+		float wheel = GetMouseWheelMove();
+		if (IsKeyPressed(KEY_EQUAL)) wheel += 1;
+		if (IsKeyPressed(KEY_MINUS)) wheel -= 1;
+		// Not so far out that a cell is under 2 px: walls would just be noise
+		float minZoom = min(1.0f, max(0.5f, 2.0f / cellSize));
+		zoom = min(max(zoom * powf(1.25f, wheel), minZoom), MAX_ZOOM);
+
+		float mazeW = (float)game.grid.cols * cellSize, mazeH = (float)game.grid.rows * cellSize;
+		float viewW = screenW / zoom, viewH = screenH / zoom;
+		camera.offset = { screenW / 2.0f, screenH / 2.0f };
+		camera.target.x = mazeW <= viewW ? mazeW / 2 : min(max(targetX, viewW / 2), mazeW - viewW / 2);
+		camera.target.y = mazeH <= viewH ? mazeH / 2 : min(max(targetY, viewH / 2), mazeH - viewH / 2);
+		camera.zoom = zoom;
+	}
+
+	CellRect Visible(const FloodGame& game, int screenW, int screenH) const {
+		const int cellSize = game.config.cellSize;
+		Vector2 topLeft = GetScreenToWorld2D({ 0, 0 }, camera);
+		Vector2 bottomRight = GetScreenToWorld2D({ (float)screenW, (float)screenH }, camera);
+		CellRect r;
+		r.x0 = max(0, (int)floorf(topLeft.x / cellSize));
+		r.y0 = max(0, (int)floorf(topLeft.y / cellSize));
+		r.x1 = min(game.grid.cols, (int)floorf(bottomRight.x / cellSize) + 1);
+		r.y1 = min(game.grid.rows, (int)floorf(bottomRight.y / cellSize) + 1);
+		r.x1 = max(r.x1, r.x0);
+		r.y1 = max(r.y1, r.y0);
+		return r;
+	}
+};
 
-		// Update oxygen
-		if (isPlayerUnderwater) {
-			oxygenLevel -= oxygenDepletionRate;
-			if (oxygenLevel < 0) oxygenLevel = 0;
+// The maze walls never change during a run, so they're drawn into textures and
+// blitted every frame instead of one DrawLineEx per wall. The maze is cut into
+// square chunks of about CHUNK_PX pixels; a chunk is drawn the first time it
+// comes into view and kept while there's room, so only what's on screen costs
+// anything, however big the maze. All dropped when FloodGame makes a new maze
+// or the cell size changes.
+class MazeLayer {
+public:
+	static const int PAD = 2;            // room for the 2 px lines on a chunk's edges
+	static const int CHUNK_PX = 512;
+	static const int MAX_CHUNKS = 96;    // textures kept, the longest unseen go first
+	static const int NEW_PER_FRAME = 8;  // the rest come in over the next frames instead of one long one
+
+	struct Chunk {
+		RenderTexture2D target;
+		int lastSeen;
+	};
+	unordered_map<int, Chunk> chunks;    // by chunk x + y * chunk columns
+	int mazeVersion = -1;
+	int cellSize = 0;
+	int chunkCells = 1;                  // cells along a chunk's side
+	int frame = 0;
+
+	// Draws the chunks in view that aren't cached yet; call before BeginDrawing(),
+	// texture mode would lose the camera inside BeginMode2D()
+	void Update(const FloodGame& game, const CellRect& visible) {
+		frame++;
+		if (mazeVersion != game.mazeVersion || cellSize != game.config.cellSize) {
+			Unload();
+			mazeVersion = game.mazeVersion;
+			cellSize = game.config.cellSize;
+			chunkCells = max(1, CHUNK_PX / cellSize);
 		}
-		else {
-			oxygenLevel += 0.5f; // Slowly recover when above water
-			if (oxygenLevel > 100) oxygenLevel = 100;
+		int made = 0;
+		ForEachChunk(game, visible, [&](int cx, int cy, int key) {
+			auto it = chunks.find(key);
+			if (it != chunks.end()) it->second.lastSeen = frame;
+			else if (made < NEW_PER_FRAME) {
+				made++;
+				Render(game, cx, cy, key);
+			}
+		});
+	}
+
+	void Draw(const FloodGame& game, const CellRect& visible) const {
+		ProfileScope zone(PROFILE_MAZE_DRAW);
+		const float side = (float)(chunkCells * cellSize + PAD * 2);
+		ForEachChunk(game, visible, [&](int cx, int cy, int key) {
+			auto it = chunks.find(key);
+			if (it == chunks.end()) return;
+			// Render textures come out upside down in raylib, hence the negative height
+			Rectangle source = { 0, 0, side, -side };
+			Vector2 at = { (float)(cx * chunkCells * cellSize - PAD), (float)(cy * chunkCells * cellSize - PAD) };
+			DrawTextureRec(it->second.target.texture, source, at, WHITE);
+			zone.Draws(1);
+		});
+	}
+
+	void Unload() {
+		for (auto& chunk : chunks) UnloadRenderTexture(chunk.second.target);
+		chunks.clear();
+	}
+
+private:
+	template <class F>
+	void ForEachChunk(const FloodGame& game, const CellRect& visible, F f) const {
+		if (visible.x0 >= visible.x1 || visible.y0 >= visible.y1) return;
+		int columns = (game.grid.cols + chunkCells - 1) / chunkCells;
+		for (int cy = visible.y0 / chunkCells; cy * chunkCells < visible.y1; cy++) {
+			for (int cx = visible.x0 / chunkCells; cx * chunkCells < visible.x1; cx++) f(cx, cy, cx + cy * columns);
 		}
+	}
 
-		// Check air bubble collection
-		for (auto& bubble : airBubbles) {
-			if (!bubble.collected) {
-				float dist = sqrt(pow(playerX - bubble.x, 2) +
-					pow(playerY - bubble.y, 2));
-				if (dist < CELL_SIZE / 2) {
-					bubble.collected = true;
-					oxygenLevel = min(100.0f, oxygenLevel + 50.0f);
-				}
+	void Render(const FloodGame& game, int cx, int cy, int key) {
+		ProfileScope zone(PROFILE_MAZE_CACHE);
+		RenderTexture2D target;
+		if ((int)chunks.size() >= MAX_CHUNKS) {
+			// Reuse the texture of the chunk unseen the longest
+			auto oldest = chunks.begin();
+			for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+				if (it->second.lastSeen < oldest->second.lastSeen) oldest = it;
 			}
+			target = oldest->second.target;
+			chunks.erase(oldest);
 		}
-
-		// Check drain switch activation
-		for (auto& drain : drainSwitches) {
-			if (!drain.activated) {
-				float dist = sqrt(pow(playerX - drain.x, 2) +
-					pow(playerY - drain.y, 2));
-				if (dist < drain.activationRadius) {
-					drain.activated = true;
-				}
+		else target = LoadRenderTexture(chunkCells * cellSize + PAD * 2, chunkCells * cellSize + PAD * 2);
+		chunks[key] = { target, frame };
+
+		BeginTextureMode(target);
+		ClearBackground(BLANK);
+		// Each wall is stored once (right/bottom of its cell), so draw those plus
+		// the maze's top and left border instead of all four per cell.
+		Color wallColor = { 200, 180, 255, 255 };
+		int x0 = cx * chunkCells, y0 = cy * chunkCells;
+		int x1 = min(x0 + chunkCells, game.grid.cols), y1 = min(y0 + chunkCells, game.grid.rows);
+		float right = PAD + (float)(x1 - x0) * cellSize;
+		float bottom = PAD + (float)(y1 - y0) * cellSize;
+		if (y0 == 0) DrawLineEx({ (float)PAD, (float)PAD }, { right, (float)PAD }, 2.0f, wallColor);
+		if (x0 == 0) DrawLineEx({ (float)PAD, (float)PAD }, { (float)PAD, bottom }, 2.0f, wallColor);
+		for (int y = y0; y < y1; y++) {
+			for (int x = x0; x < x1; x++) {
+				float px = PAD + (float)(x - x0) * cellSize;
+				float py = PAD + (float)(y - y0) * cellSize;
+				int walls = game.grid.WallBits(x, y);
+
+				if (walls & 2)
+					DrawLineEx({ px, py + cellSize }, { px + cellSize, py + cellSize }, 2.0f, wallColor);
+				if (walls & 1)
+					DrawLineEx({ px + cellSize, py }, { px + cellSize, py + cellSize }, 2.0f, wallColor);
+				zone.Draws((walls & 1) + (walls >> 1));
 			}
 		}
+		EndTextureMode();
 	}
+};
 
-	void Draw(int offsetX, int offsetY) {
-		float waterTopY = offsetY + maxWaterLevel - waterLevel; // Inner Left edge 
-
-		if (waterLevel > 0) {
-			// Draw main water body
-			Color waterColor = { 30, 60, 150, 160 };
-			DrawRectangle(offsetX, waterTopY, width * CELL_SIZE, waterLevel, waterColor);
+// Corner map for mazes bigger than the screen: where you've been, the water,
+// you, the drains you've found and the exit. It's a small image, a pixel per
+// cell, or per block of cells on big mazes, updated from the cells that changed
+// each tick (the ones the player just revealed, the flood frontier and cells
+// that just filled) and sent to the GPU a tile at a time, only the tiles that
+// changed. Water shows through the fog, dimmed.
+class Minimap {
+public:
+	static constexpr int MAX_SIDE = 256;  // image pixels along the maze's longer side
+	static constexpr int TILE = 32;       // pixels along the side of one upload
+	static constexpr int REVEAL = 2;      // cells around the player that count as explored
+	static constexpr int WIDGET = 200;    // screen pixels along the longer side
+	static constexpr uint8_t EXPLORED = 1, WET = 2;
+
+	Texture2D texture = { 0 };
+	int mazeVersion = -1;
+
+	// After every tick: picks up what changed in it
+	void Track(const FloodGame& game) {
+		if (mazeVersion != game.mazeVersion) Reset(game);
+		// A cell only changes depth in the frontier, or fills and leaves it in the
+		// same tick; those are the new end of filled. Drained cells go back into
+		// the frontier.
+		const FloodField& flood = game.waterSystem.flood;
+		for (int cell : flood.frontier) SetWet(cell, flood.depth[cell] >= FloodField::FULL / 2);
+		for (; filledSeen < flood.filled.size(); filledSeen++) SetWet(flood.filled[filledSeen], true);
+		filledSeen = flood.filled.size();
+
+		const int cellSize = game.config.cellSize;
+		int x = min(max((int)(game.player.x / cellSize), 0), cols - 1);
+		int y = min(max((int)(game.player.y / cellSize), 0), rows - 1);
+		if (x + y * cols == playerCell) return;
+		playerCell = x + y * cols;
+		for (int ny = max(y - REVEAL, 0); ny <= min(y + REVEAL, rows - 1); ny++) {
+			for (int nx = max(x - REVEAL, 0); nx <= min(x + REVEAL, cols - 1); nx++) Explore(nx + ny * cols);
 		}
+	}
 
-		// Draw air bubbles
-		for (auto& bubble : airBubbles) {
-			if (!bubble.collected) {
-				DrawCircleGradient(offsetX + bubble.x,offsetY + bubble.y,12, { 200, 200, 255, 200 }, { 100, 100, 200, 100 });
-				DrawCircle(offsetX + bubble.x - 3,offsetY + bubble.y - 3,3, { 255, 255, 255, 255 });
+	// Once a frame, before BeginDrawing(): sends the changed tiles
+	void Upload(const FloodGame& game) {
+		ProfileScope zone(PROFILE_MINIMAP);
+		if (mazeVersion != game.mazeVersion) Reset(game);
+		const int tilesX = (width + TILE - 1) / TILE;
+		for (size_t t = 0; t < dirty.size(); t++) {
+			if (!dirty[t]) continue;
+			dirty[t] = 0;
+			int x0 = (int)t % tilesX * TILE, y0 = (int)t / tilesX * TILE;
+			int w = min(TILE, width - x0), h = min(TILE, height - y0);
+			// UpdateTextureRec() takes the rectangle's pixels packed together
+			scratch.resize((size_t)w * h);
+			for (int y = 0; y < h; y++) {
+				copy(pixels.begin() + (size_t)(y0 + y) * width + x0, pixels.begin() + (size_t)(y0 + y) * width + x0 + w,
+					scratch.begin() + (size_t)y * w);
 			}
+			UpdateTextureRec(texture, { (float)x0, (float)y0, (float)w, (float)h }, scratch.data());
+			zone.Draws(1);
 		}
+	}
 
-		// Draw drain switches
-		for (auto& drain : drainSwitches) {
-			Color switchColor = drain.activated ? GREEN : RED;
-			Color glowColor = drain.activated ? Color{ 0, 255, 0, 50 } : Color{ 255, 0, 0, 50 };
-
-			// Glow effect also Labeling an also swith bogy
-			DrawCircle(offsetX + drain.x, offsetY + drain.y,drain.activationRadius, glowColor);
-
-			DrawCircle(offsetX + drain.x, offsetY + drain.y, 12, BLACK);
-			DrawCircle(offsetX + drain.x, offsetY + drain.y, 10, switchColor);
-
-			
-			const char* text = drain.activated ? "ON" : "OFF";
-			DrawText(text, offsetX + drain.x - 10,
-				offsetY + drain.y - 25, 10, switchColor);
+	void Draw(const FloodGame& game, float alpha, const CellRect& visible, int screenW, int screenH) const {
+		ProfileScope zone(PROFILE_MINIMAP);
+		zone.Draws(5 + (uint32_t)game.waterSystem.drainSwitches.size());
+		const float scale = (float)WIDGET / max(cols, rows);  // screen pixels per cell
+		const float mapW = cols * scale, mapH = rows * scale;
+		const float left = screenW - mapW - 10, top = screenH - mapH - 40;
+		const int cellSize = game.config.cellSize;
+
+		DrawRectangle((int)left - 3, (int)top - 3, (int)mapW + 6, (int)mapH + 6, Fade(BLACK, 0.6f));
+		// Edge blocks may be part empty; the image covers whole blocks
+		Rectangle source = { 0, 0, (float)cols / block, (float)rows / block };
+		DrawTexturePro(texture, source, { left, top, mapW, mapH }, { 0, 0 }, 0.0f, WHITE);
+		DrawRectangleLinesEx({ left + visible.x0 * scale, top + visible.y0 * scale,
+			(visible.x1 - visible.x0) * scale, (visible.y1 - visible.y0) * scale }, 1.0f, Fade(WHITE, 0.5f));
+
+		DrawCircle(left + (cols - 0.5f) * scale, top + (rows - 0.5f) * scale, max(3.0f, scale / 2), GREEN);
+		for (auto& drain : game.waterSystem.drainSwitches) {
+			// Tiny mazes get their drains placed outside the grid
+			int x = min(max((int)(drain.x / cellSize), 0), cols - 1);
+			int y = min(max((int)(drain.y / cellSize), 0), rows - 1);
+			if (!(cells[x + y * cols] & EXPLORED)) continue;
+			DrawCircle(left + drain.x / cellSize * scale, top + drain.y / cellSize * scale, max(2.0f, scale / 2),
+				drain.activated ? GREEN : RED);
 		}
+		DrawCircle(left + game.player.DrawX(alpha) / cellSize * scale, top + game.player.DrawY(alpha) / cellSize * scale,
+			max(2.5f, scale / 2), WHITE);
+		DrawRectangleLines((int)left - 3, (int)top - 3, (int)mapW + 6, (int)mapH + 6, barBorder);
 	}
 
-	void DrawUI(int screenW, int screenH) {
-		// Water level indicator
-		int indicatorX = 10;
-		int indicatorY = 120;
-		DrawRectangle(indicatorX, indicatorY, 30, 200, Fade(BLACK, 0.5f));
-		DrawRectangle(indicatorX, indicatorY + 200 - (waterLevel / maxWaterLevel) * 200,30, (waterLevel / maxWaterLevel) * 200, Fade(BLUE, 0.7f));
-		DrawRectangleLines(indicatorX, indicatorY, 30, 200, WHITE);
-		DrawText("WATER", indicatorX - 5, indicatorY - 20, 16, BLUE);
-
-		// Oxygen bar (only whn prson is underwater or low oxygen)
-		if (isPlayerUnderwater || oxygenLevel < 100) {
-			int barX = screenW / 2 - 150;
-			int barY = 80;
-
-			// Background
-			DrawRectangle(barX - 2, barY - 2, 304, 24, BLACK);
-			
-			// Oxygen bar
-			Color oxyColor;
-			if (oxygenLevel > 60) oxyColor = SKYBLUE;
-			else if (oxygenLevel > 30) oxyColor = YELLOW;
-			else oxyColor = RED;
-
-			DrawRectangle(barX, barY, (int)(300 * oxygenLevel / 100), 20, oxyColor);
-			DrawRectangleLines(barX, barY, 300, 20, WHITE);
-			// Text
-			DrawText("OXYGEN", barX + 120, barY + 2, 16, WHITE);
-			// Critical warning
-			if (oxygenLevel < 30) {
-				if ((int)(GetTime() * 3) % 2 == 0) {
-					DrawText("WARNING: LOW OXYGEN!",
-						screenW / 2 - MeasureText("WARNING: LOW OXYGEN!", 20) / 2,
-						barY + 30, 20, RED);
-				}
-			}
-		}
+	void Unload() {
+		if (texture.id != 0) UnloadTexture(texture);
+		texture = { 0 };
+	}
 
-		// Drain status
-		int drainY = 350;
-		DrawText("DRAIN SWITCHES:", 10, drainY, 14, WHITE);
-		for (int i = 0; i < drainSwitches.size(); i++) {
-			Color statusColor = drainSwitches[i].activated ? GREEN : RED;
-			DrawCircle(25 + i * 40, drainY + 27, 10, statusColor);
-			DrawText(TextFormat("%d", i + 1), 22 + i * 40, drainY + 22, 12, WHITE);
+private:
+	int cols = 0, rows = 0;
+	int block = 1;                   // cells along a pixel's side
+	int width = 0, height = 0;       // image size
+	vector<uint8_t> cells;           // EXPLORED | WET per cell
+	vector<uint16_t> explored, wet;  // per pixel, cells of its block that are
+	vector<Color> pixels;
+	vector<uint8_t> dirty;           // per tile, waiting for Upload()
+	vector<Color> scratch;
+	size_t filledSeen = 0;
+	int playerCell = -1;
+
+	void Reset(const FloodGame& game) {
+		mazeVersion = game.mazeVersion;
+		cols = game.grid.cols;
+		rows = game.grid.rows;
+		block = max(1, (max(cols, rows) + MAX_SIDE - 1) / MAX_SIDE);
+		int w = (cols + block - 1) / block, h = (rows + block - 1) / block;
+		if (texture.id == 0 || w != width || h != height) {
+			Unload();
+			width = w;
+			height = h;
+			Image image = { nullptr, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+			pixels.assign((size_t)width * height, Color{ 0, 0, 0, 0 });
+			image.data = pixels.data();
+			texture = LoadTextureFromImage(image);
 		}
+		cells.assign((size_t)cols * rows, 0);
+		explored.assign((size_t)width * height, 0);
+		wet.assign((size_t)width * height, 0);
+		for (int p = 0; p < width * height; p++) pixels[p] = Shade(p);
+		dirty.assign((size_t)((width + TILE - 1) / TILE) * ((height + TILE - 1) / TILE), 1);
+		filledSeen = 0;
+		playerCell = -1;
 	}
 
-	bool IsGameOver() {
-		return oxygenLevel <= 0;
+	int PixelOf(int cell) const {
+		int y = cell / cols, x = cell - y * cols;
+		return x / block + y / block * width;
 	}
 
-	float GetWaterPercentage() {
-		return (waterLevel / maxWaterLevel) * 100;
+	void Explore(int cell) {
+		if (cells[cell] & EXPLORED) return;
+		cells[cell] |= EXPLORED;
+		int p = PixelOf(cell);
+		explored[p]++;
+		Repaint(p);
 	}
-};
 
-class Player2D {
-public:
-	float x, y;
-	float speed = 2.0f;
-	float size = CELL_SIZE * 0.6f;
+	void SetWet(int cell, bool isWet) {
+		if (((cells[cell] & WET) != 0) == isWet) return;
+		cells[cell] ^= WET;
+		int p = PixelOf(cell);
+		if (isWet) wet[p]++;
+		else wet[p]--;
+		Repaint(p);
+	}
 
-	Player2D() {
-		x = CELL_SIZE / 2;
-		y = CELL_SIZE / 2;
+	void Repaint(int p) {
+		pixels[p] = Shade(p);
+		int x = p % width, y = p / width;
+		dirty[x / TILE + y / TILE * ((width + TILE - 1) / TILE)] = 1;
 	}
 
-	void Reset() { // This is for the new game. 
-		x = CELL_SIZE / 2;
-		y = CELL_SIZE / 2;
+	// Fog or floor, blended towards water by how much of the block is wet
+	Color Shade(int p) const {
+		int x = p % width, y = p / width;
+		int blockCells = min(block, cols - x * block) * min(block, rows - y * block);
+		bool seen = explored[p] > 0;
+		Color ground = seen ? Color{ 90, 60, 120, 255 } : Color{ 20, 16, 28, 255 };
+		Color water = seen ? Color{ 40, 90, 210, 255 } : Color{ 25, 40, 95, 255 };
+		float t = (float)wet[p] / blockCells;
+		return Color{ (unsigned char)(ground.r + (water.r - ground.r) * t), (unsigned char)(ground.g + (water.g - ground.g) * t),
+			(unsigned char)(ground.b + (water.b - ground.b) * t), 255 };
 	}
+};
 
-	void Update(vector<Cell>& grid) {
-		float newX = x;
-		float newY = y;
+// Every run is kept as last.replay when it ends or is left for the menu;
+// ./maze_master --replay last.replay plays it back
+const char* LAST_REPLAY = "last.replay";
 
-		// Movement input
-		if (IsKeyDown(KEY_W) || IsKeyDown(KEY_UP)) newY -= speed;
-		if (IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN)) newY += speed;
-		if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT)) newX -= speed;
-		if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) newX += speed;
+template <class Game>
+void SaveRun(const Game& game, bool& saved) {
+	if (saved || game.replay.Ticks() == 0) return;
+	saved = true;
+	if (!game.replay.Save(LAST_REPLAY)) TraceLog(LOG_WARNING, "Could not write %s", LAST_REPLAY);
+}
 
-		// Check collision with walls
-		if (CanMoveTo(newX, newY, grid)) {
-			x = newX;
-			y = newY;
-		}
-		else {
-			// Try moving on single axis
-			if (CanMoveTo(newX, y, grid)) x = newX;
-			else if (CanMoveTo(x, newY, grid)) y = newY;
-		}
-	}
+// The game seed, top left: the same seed gives the same maze anywhere. C copies it.
+void DrawSeed(uint64_t seed) {
+	const char* text = TextFormat("Seed %016llX", (unsigned long long)seed);
+	DrawText(text, 10, 38, 14, Fade(WHITE, 0.6f));
+	if (IsKeyPressed(KEY_C)) SetClipboardText(TextFormat("%016llX", (unsigned long long)seed));
+}
 
-	bool CanMoveTo(float newX, float newY, vector<Cell>& grid) {
-		// Geting grid position
-		int gridX = (int)(newX / CELL_SIZE);
-		int gridY = (int)(newY / CELL_SIZE);
+// Keyboard -> InputBits for FloodGame::Step
+uint8_t ReadPlayerInput() {
+	uint8_t input = 0;
+	if (IsKeyDown(KEY_W) || IsKeyDown(KEY_UP)) input |= INPUT_UP;
+	if (IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN)) input |= INPUT_DOWN;
+	if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT)) input |= INPUT_LEFT;
+	if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) input |= INPUT_RIGHT;
+	return input;
+}
 
-		// Checking th boundary
-		if (newX < size / 2 || newX > width * CELL_SIZE - size / 2) return false;
-		if (newY < size / 2 || newY > height * CELL_SIZE - size / 2) return false;
+// Endless mode: the view follows the player vertically and only the live rows
+// in the ring that are on screen get drawn.
+void DrawEndless(const EndlessGame& endless, float alpha, int screenW, int screenH) {
+	const int cellSize = endless.config.cellSize;
+	const MazeRowRing& ring = endless.ring;
+	int mazeWidth = ring.cols * cellSize;
+	int offsetX = (screenW - mazeWidth) / 2;
+	int offsetY = (int)(screenH * 0.6f - endless.player.DrawY(alpha));
+
+	DrawRectangle(offsetX - 20, 0, mazeWidth + 40, screenH, Fade(BLACK, 0.5f));
+
+	int firstRow = max(ring.FirstRow(), (int)floor((float)-offsetY / cellSize));
+	int endRow = min(ring.EndRow(), (int)ceil((float)(screenH - offsetY) / cellSize));
+
+	Color wallColor = { 200, 180, 255, 255 };
+	for (int y = firstRow; y < endRow; y++) {
+		int py = offsetY + y * cellSize;
+		DrawRectangle(offsetX, py, mazeWidth, cellSize, Fade(purpleTop, 0.2f));
+		DrawLineEx({ (float)offsetX, (float)py },
+			{ (float)offsetX, (float)(py + cellSize) }, 2.0f, wallColor);
+		if (y == ring.FirstRow())
+			DrawLineEx({ (float)offsetX, (float)py },
+				{ (float)(offsetX + mazeWidth), (float)py }, 2.0f, wallColor);
+		for (int x = 0; x < ring.cols; x++) {
+			int px = offsetX + x * cellSize;
+			int walls = ring.WallBits(x, y);
+			if ((walls & 2) || y == ring.EndRow() - 1)
+				DrawLineEx({ (float)px, (float)(py + cellSize) },
+					{ (float)(px + cellSize), (float)(py + cellSize) }, 2.0f, wallColor);
+			if (walls & 1)
+				DrawLineEx({ (float)(px + cellSize), (float)py },
+					{ (float)(px + cellSize), (float)(py + cellSize) }, 2.0f, wallColor);
+		}
+	}
 
-		if (gridX < 0 || gridX >= width || gridY < 0 || gridY >= height) return false;
+	float waterY = offsetY + endless.DrawWaterTopY(alpha);
+	if (waterY < screenH) {
+		DrawRectangle(offsetX, (int)max(0.0f, waterY), mazeWidth, screenH, Color{ 30, 60, 150, 160 });
+	}
 
-		int idx = gridX + gridY * width;
+	DrawPlayer(endless.player, alpha, offsetX, offsetY, endless.isPlayerUnderwater);
 
-		// Check collision with walls
-		float cellX = fmod(newX, CELL_SIZE);
-		float cellY = fmod(newY, CELL_SIZE);
+	DrawRectangle(0, 0, screenW, 60, Fade(BLACK, 0.5f));
+	DrawText("ENDLESS FLOOD", (screenW - MeasureText("ENDLESS FLOOD", 36)) / 2, 10, 36, textAccent);
+	DrawText(TextFormat("Height: %d", endless.RowsClimbed()), screenW - 140, 10, 16, WHITE);
+	DrawText(TextFormat("Time: %.1fs", endless.ticks * TICK_DT), screenW - 140, 30, 16, WHITE);
 
-		float buffer = size / 2;
+	int barX = screenW / 2 - 150;
+	int barY = 80;
+	Color oxyColor = endless.oxygenLevel > 60 ? SKYBLUE : endless.oxygenLevel > 30 ? YELLOW : RED;
+	DrawRectangle(barX - 2, barY - 2, 304, 24, BLACK);
+	DrawRectangle(barX, barY, (int)(300 * endless.oxygenLevel / 100), 20, oxyColor);
+	DrawRectangleLines(barX, barY, 300, 20, WHITE);
+	DrawText("OXYGEN", barX + 120, barY + 2, 16, WHITE);
+}
 
-		// Check walls
-		if (grid[idx].walls[0] && cellY < buffer) return false; // Top
-		if (grid[idx].walls[1] && cellY > CELL_SIZE - buffer) return false; // Bottom
-		if (grid[idx].walls[2] && cellX < buffer) return false; // Left
-		if (grid[idx].walls[3] && cellX > CELL_SIZE - buffer) return false; // Right
+// Draws a ParticleField with one pre-rendered glow sprite, so all particles go
+// out as textured quads in a single batch instead of three DrawCircle calls each.
+// The sprite sheet has one glow per palette colour; per-particle alpha is the tint.
+class ParticleSystem {
+public:
+	static const int SPRITE = 32; // px per glow; the core radius is SPRITE / 4
+	ParticleField field;
+	Texture2D sprite = { 0 };
 
-		return true;
+	void Init(int numParticles, int screenWidth, int screenHeight, uint64_t seed) {
+		field.Init(numParticles, screenWidth, screenHeight, seed);
+		if (sprite.id == 0) BuildSprite();
 	}
 
-	void Draw(int offsetX, int offsetY, bool isUnderwater) {
-		Color playerColor = isUnderwater ? Color{ 100, 150, 255, 255 } : Color{ 255, 200, 100, 255 };
+	void Resize(int screenWidth, int screenHeight) {
+		field.Resize(screenWidth, screenHeight);
+	}
 
-		// Draw player
-		DrawCircle(offsetX + x, offsetY + y, size / 2, playerColor);
-		DrawCircleLines(offsetX + x, offsetY + y, size / 2, BLACK);
+	void Update() {
+		field.Update();
+	}
 
-		// Draw bubble effect if underwater
-		if (isUnderwater) {
-			for (int i = 0; i < 3; i++) {
-				float bubbleY = y - 10 - i * 5 - sin(GetTime() * 3) * 3;
-				DrawCircle(offsetX + x, offsetY + bubbleY, 2 - i * 0.5f,
-					Fade(WHITE, 0.5f - i * 0.1f));
+	// Same layers the three circles drew: a faint glow at twice the size,
+	// the solid core, and a half-white centre
+	void BuildSprite() {
+		const Color palette[ParticleField::PALETTE_SIZE] = {
+			{ 180, 120, 255, 255 }, { 140, 80, 200, 255 }, { 200, 180, 255, 255 }, { 255, 255, 255, 255 }
+		};
+		const float core = SPRITE / 4.0f;
+		Image image = GenImageColor(SPRITE * ParticleField::PALETTE_SIZE, SPRITE, BLANK);
+		for (int c = 0; c < ParticleField::PALETTE_SIZE; c++) {
+			Color base = palette[c];
+			Color centre = { (unsigned char)((base.r + 255) / 2), (unsigned char)((base.g + 255) / 2),
+				(unsigned char)((base.b + 255) / 2), 255 };
+			for (int py = 0; py < SPRITE; py++) {
+				for (int px = 0; px < SPRITE; px++) {
+					float r = sqrtf((px + 0.5f - SPRITE / 2.0f) * (px + 0.5f - SPRITE / 2.0f)
+						+ (py + 0.5f - SPRITE / 2.0f) * (py + 0.5f - SPRITE / 2.0f));
+					Color col = BLANK;
+					if (r <= core * 0.5f) col = centre;
+					else if (r <= core) col = base;
+					else if (r <= core * 2) col = Fade(base, 0.3f);
+					ImageDrawPixel(&image, c * SPRITE + px, py, col);
+				}
 			}
 		}
+		sprite = LoadTextureFromImage(image);
+		UnloadImage(image);
+		SetTextureFilter(sprite, TEXTURE_FILTER_BILINEAR);
 	}
 
-	bool HasReachedExit() {
-		float exitX = (width - 0.5f) * CELL_SIZE;
-		float exitY = (height - 0.5f) * CELL_SIZE;
-		float dist = sqrt(pow(x - exitX, 2) + pow(y - exitY, 2));
-		return dist < CELL_SIZE / 2;
+	void Draw() {
+		ProfileScope zone(PROFILE_PARTICLES_DRAW);
+		zone.Draws(field.count);
+		for (int i = 0; i < field.count; i++) {
+			float glow = field.size[i] * 2.0f;
+			Rectangle source = { (float)(field.color[i] * SPRITE), 0, (float)SPRITE, (float)SPRITE };
+			Rectangle dest = { field.x[i] - glow, field.y[i] - glow, glow * 2, glow * 2 };
+			DrawTexturePro(sprite, source, dest, { 0, 0 }, 0.0f, Fade(WHITE, field.alpha[i]));
+		}
 	}
-};
 
-struct Particle {
-	Vector2 position;
-	Vector2 velocity;
-	float size;
-	float alpha;
-	float life;
-	Color baseColor;
+	void Unload() {
+		if (sprite.id != 0) UnloadTexture(sprite);
+		sprite = { 0 };
+	}
 };
 
-class ParticleSystem {
+// The background gradient only changes along y, so it's baked into a 1 px wide
+// texture (one pixel per scanline) and stretched across the screen: one draw
+// call instead of one DrawLine per scanline. Rebuilt when the screen height changes.
+class GradientCache {
 public:
-	vector<Particle> particles;
-	int screenW = 0;
-	int screenH = 0;
+	Texture2D texture = { 0 };
+	int height = 0;
 
-	//ParticleSystem() : screenW(0), screenH(0) {}
-
-	void Init(int numParticles, int screenWidth, int screenHeight) {
-		screenW = screenWidth;
-		screenH = screenHeight;
-		particles.clear();
+	void Draw(int screenWidth, int screenHeight) {
+		if (texture.id == 0 || height != screenHeight) Rebuild(screenHeight);
+		DrawTexturePro(texture, { 0, 0, 1, (float)screenHeight },
+			{ 0, 0, (float)screenWidth, (float)screenHeight }, { 0, 0 }, 0.0f, WHITE);
+	}
 
-		for (int i = 0; i < numParticles; i++) {
-			particles.push_back(CreateParticle());
+	void Rebuild(int screenHeight) {
+		Unload();
+		height = screenHeight;
+		Image image = GenImageColor(1, screenHeight, BLANK);
+		for (int y = 0; y < screenHeight; y++) {
+			float t = (float)y / screenHeight;
+			Color lineCol = {
+				(purpleTop.r * (1 - t) + blackBottom.r * t),
+				(purpleTop.g * (1 - t) + blackBottom.g * t),
+				(purpleTop.b * (1 - t) + blackBottom.b * t),
+				255
+			};
+			ImageDrawPixel(&image, 0, y, lineCol);
 		}
+		texture = LoadTextureFromImage(image);
+		UnloadImage(image);
+		SetTextureFilter(texture, TEXTURE_FILTER_POINT);
 	}
 
-	void Resize(int screenWidth, int screenHeight) {
-		screenW = screenWidth;
-		screenH = screenHeight;
+	void Unload() {
+		if (texture.id != 0) UnloadTexture(texture);
+		texture = { 0 };
 	}
+};
+GradientCache gradientCache;
 
-	Particle CreateParticle() {
-		Particle p;
-		int w = (screenW > 0) ? screenW : 800;
-		int h = (screenH > 0) ? screenH : 600;
+void DrawGradientBackground(int screenWidth, int screenHeight) {
+	gradientCache.Draw(screenWidth, screenHeight);
+}
 
-		p.position = { (float)(rand() % w), (float)(rand() % h) };
-		p.velocity = {((float)(rand() % 100) - 50) / 50.0f,-((float)(rand() % 50) + 20) / 30.0f};
+// Maze sizes offered on the menu, cycled with [ and ]
+const int menuMazeSizes[] = { 20, 32, 48, 64 };
+const int menuMazeSizeCount = sizeof(menuMazeSizes) / sizeof(menuMazeSizes[0]);
 
-		p.size = (float)(rand() % 4) + 1.5f;
-		p.alpha = (float)(rand() % 100) / 100.0f * 0.7f + 0.1f;
+// Biggest cell size (up to the original 20 px) that fits the maze on screen
+int FitCellSize(int cols, int rows, int screenW, int screenH) {
+	int cell = min((screenW - 80) / cols, (screenH - 160) / rows);
+	return max(4, min(20, cell));
+}
 
-		int colorChoice = rand() % 4;
-		switch (colorChoice) {
-		case 0: p.baseColor = { 180, 120, 255, 255 }; break;
-		case 1: p.baseColor = { 140, 80, 200, 255 }; break;
-		case 2: p.baseColor = { 200, 180, 255, 255 }; break;
-		case 3: p.baseColor = { 255, 255, 255, 255 }; break;
-		}
-		return p;
-	}
-
-	void Update() {
-		int w = (screenW > 0) ? screenW : 800;
-		int h = (screenH > 0) ? screenH : 600;
-
-		for (size_t i = 0; i < particles.size(); i++) {
-			Particle& p = particles[i];
-
-			p.position.x += p.velocity.x;
-			p.position.y += p.velocity.y;
-			p.position.x += sin(p.life * 0.02f) * 0.3f;
-			if ( p.position.y < -20 ||p.position.x < -20 || p.position.x > w + 20) {
-				p.position = { (float)(rand() % w), (float)(h + rand() % 50) };
-				p.velocity = {
-					((float)(rand() % 100) - 50) / 50.0f,
-					-((float)(rand() % 50) + 20) / 30.0f
-				};
-			}
-		}
+// F3: each phase of the frame over the last few seconds, from the profiler
+void DrawProfilerOverlay(int screenW) {
+	const Profiler& profiler = Profiler::Get();
+	const int rowH = 14, width = 330;
+	const int columns[] = { 120, 170, 220, 275 }; // min, avg, p99, draws
+	int x = screenW - width - 10, y = 70;
+	DrawRectangle(x - 6, y - 6, width + 12, rowH * (PROFILE_ZONE_COUNT + 2) + 12, Fade(BLACK, 0.75f));
+	DrawText("phase (ms)", x, y, 12, YELLOW);
+	DrawText("min", x + columns[0], y, 12, YELLOW);
+	DrawText("avg", x + columns[1], y, 12, YELLOW);
+	DrawText("p99", x + columns[2], y, 12, YELLOW);
+	DrawText("draws", x + columns[3], y, 12, YELLOW);
+	for (int z = 0; z < PROFILE_ZONE_COUNT; z++) {
+		Profiler::ZoneStats stats = profiler.Stats(z);
+		y += rowH;
+		Color color = stats.frames == 0 ? GRAY : z == PROFILE_FRAME ? WHITE : textMain;
+		DrawText(ProfileZoneName(z), x, y, 12, color);
+		if (stats.frames == 0) continue;
+		DrawText(TextFormat("%.2f", stats.minMs), x + columns[0], y, 12, color);
+		DrawText(TextFormat("%.2f", stats.avgMs), x + columns[1], y, 12, color);
+		DrawText(TextFormat("%.2f", stats.p99Ms), x + columns[2], y, 12, color);
+		DrawText(TextFormat("%.0f", stats.draws), x + columns[3], y, 12, color);
 	}
+	DrawText("F4: save profile.csv and profile.json", x, y + rowH, 12, GRAY);
+}
 
-	void Draw() {
-		for (const Particle& p : particles) {
-			Color drawColor = {
-				p.baseColor.r,
-				p.baseColor.g,
-				p.baseColor.b,
-				(unsigned char)(p.alpha * 255)
-			};
+// EndDrawing() for the main loop: the overlay goes on top, then the frame is presented
+void Present(bool showProfiler) {
+	if (showProfiler) DrawProfilerOverlay(GetScreenWidth());
+	ProfileScope zone(PROFILE_PRESENT);
+	EndDrawing();
+}
 
-			DrawCircle((int)p.position.x, (int)p.position.y, p.size * 2.0f,
-				Fade(drawColor, p.alpha * 0.3f));
-			DrawCircle((int)p.position.x, (int)p.position.y, p.size, drawColor);
-			DrawCircle((int)p.position.x, (int)p.position.y, p.size * 0.5f,
-				Fade(WHITE, p.alpha * 0.5f));
-		}
-	}
-};
+// Loads the menu art and music behind the loading screen. Files are read and
+// images decoded on a worker thread; the textures and the music stream are
+// made on the main thread, which owns the GL context and the audio device.
+// The worker also picks the first maze, so Start doesn't have to wait for it.
+class AssetLoader {
+public:
+	static const int IMAGE_COUNT = 4;
+	const char* imageFiles[IMAGE_COUNT] = { "maze_master.png", "newbutstart.png", "newbutabout.png", "nerbutexit.png" };
+	const char* musicFile = "music.mp3";
 
-void DrawGradientBackground(int screenWidth, int screenHeight) {
-	for (int y = 0; y < screenHeight; y++) {
-		float t = (float)y / screenHeight;
-		Color lineCol = {
-			(purpleTop.r * (1 - t) + blackBottom.r * t),
-			(purpleTop.g * (1 - t) + blackBottom.g * t),
-			(purpleTop.b * (1 - t) + blackBottom.b * t),
-			255
-		};
-		DrawLine(0, y, screenWidth, y, lineCol);
-	}
-}
+	Texture2D textures[IMAGE_COUNT] = {};
+	Music music = {};
+	PreparedMaze firstMaze;  // only once MazeReady()
 
-int index(int x, int y) {
-	if (x < 0 || x >= width || y < 0 || y >= height) {
-		return -1;
+	~AssetLoader() {
+		if (worker.joinable()) worker.join();
+		if (musicData) UnloadFileData(musicData); // the stream played straight from it
 	}
-	return x + y * width;
-}
 
-void maze_generation(vector<Cell>& grid, vector<int> stack) {
-	// Clear grid
-	for (int i = 0; i < width * height; i++) {
-		grid[i].visited = false;
-		grid[i].walls[0] = true;
-		grid[i].walls[1] = true;
-		grid[i].walls[2] = true;
-		grid[i].walls[3] = true;
-	}
-	stack.clear();
-
-	int currentCell_x = 0;
-	int currentCell_y = 0;
-
-	int check_coordinate = index(currentCell_x, currentCell_y);
-	grid[check_coordinate].visited = true;
-	stack.push_back(check_coordinate);
-
-	while (stack.empty() == false) {
-		vector<int> neighbours;
-
-		int top = index(currentCell_x, currentCell_y - 1);
-		int left = index(currentCell_x - 1, currentCell_y);
-		int bottom = index(currentCell_x, currentCell_y + 1);
-		int right = index(currentCell_x + 1, currentCell_y);
-
-		if (top != -1 && grid[top].visited == false) neighbours.push_back(top);
-		if (left != -1 && grid[left].visited == false) neighbours.push_back(left);
-		if (bottom != -1 && grid[bottom].visited == false) neighbours.push_back(bottom);
-		if (right != -1 && grid[right].visited == false) neighbours.push_back(right);
-
-		if (neighbours.empty() == false) {
-			int randomIndex = rand() % neighbours.size();
-			int value = neighbours[randomIndex];
-
-			if (value == top) {
-				grid[check_coordinate].walls[0] = false;
-				grid[value].walls[1] = false;
-				currentCell_y -= 1;
+	// pickMaze: also pick the maze for `seed` at that size
+	void Start(bool pickMaze, const MazeConfig& config, MazeAlgorithm algorithm, uint64_t seed, int threads) {
+		steps = 1 + IMAGE_COUNT + (pickMaze ? 1 : 0);
+		worker = std::thread([=] {
+			musicData = LoadFileData(musicFile, &musicSize);
+			read.fetch_add(1, std::memory_order_release);
+			for (int i = 0; i < IMAGE_COUNT; i++) {
+				images[i] = LoadImage(imageFiles[i]);
+				read.fetch_add(1, std::memory_order_release);
 			}
-			else if (value == left) {
-				grid[check_coordinate].walls[2] = false;
-				grid[value].walls[3] = false;
-				currentCell_x -= 1;
+			if (pickMaze) {
+				MazePicker picker;
+				picker.Pick(config, algorithm, seed, threads, firstMaze);
+				read.fetch_add(1, std::memory_order_release);
 			}
-			else if (value == bottom) {
-				grid[check_coordinate].walls[1] = false;
-				grid[value].walls[0] = false;
-				currentCell_y += 1;
+		});
+	}
+
+	// Main thread, once a frame: uploads whatever the worker has finished
+	void Poll() {
+		int ready = read.load(std::memory_order_acquire);
+		for (; made < ready && made <= IMAGE_COUNT; made++) {
+			if (made == 0) {
+				if (musicData) music = LoadMusicStreamFromMemory(".mp3", musicData, musicSize);
+				PlayMusicStream(music);
+				SetMusicVolume(music, 1.0f);
 			}
-			else if (value == right) {
-				grid[check_coordinate].walls[3] = false;
-				grid[value].walls[2] = false;
-				currentCell_x += 1;
+			else {
+				textures[made - 1] = LoadTextureFromImage(images[made - 1]);
+				UnloadImage(images[made - 1]);
 			}
-
-			check_coordinate = index(currentCell_x, currentCell_y);
-			grid[check_coordinate].visited = true;
-			stack.push_back(check_coordinate);
 		}
-		else {
-			stack.pop_back();
-			if (stack.empty() == false) {
-				check_coordinate = stack.back();
-				currentCell_x = check_coordinate % width;
-				currentCell_y = check_coordinate / width;
+		if (ready == steps) made = steps;
+	}
+
+	// Every step counts twice, once read and once made
+	float Progress() const {
+		return steps > 0 ? (read.load(std::memory_order_acquire) + made) / (2.0f * steps) : 0.0f;
+	}
+
+	bool Done() const { return steps > 0 && made == steps; }
+	bool MazeReady() const { return Done() && steps > 1 + IMAGE_COUNT; }
+
+private:
+	std::thread worker;
+	std::atomic<int> read{ 0 };  // steps the worker has done: music, each image, the maze
+	int made = 0;                // steps the main thread has finished with
+	int steps = 0;
+	unsigned char* musicData = nullptr;
+	int musicSize = 0;
+	Image images[IMAGE_COUNT] = {};
+};
+
+int main(int argc, char** argv) {
+	Rng seedRng((uint64_t)time(nullptr)); // seeds for new games; each game owns its randomness from there
+
+	// Game objects
+	FloodGame game;
+	EndlessGame endless;
+	int state = 0;
+	bool showHint = false;  // H: route hint arrow
+	bool autoSolve = false; // P: let the solver walk
+	SolverBot solverBot;
+	MazeLayer mazeLayer;
+	FollowCamera camera;
+	Minimap minimap;
+	bool showMinimap = true;
+	TickClock clock;        // the game runs at TICK_RATE whatever the frame rate
+	Replay playback;        // --replay: inputs come from here instead of the keyboard
+	bool playingBack = false;
+	bool runSaved = false;
+
+	// --size WxH, --cell N and --gen NAME override the menu choice;
+	// --particles N sets how many background particles float around,
+	// --rivals N adds that many AI rivals racing for the exit,
+	// --fps N sets the render rate (the game itself always ticks at TICK_RATE),
+	// --replay FILE plays a recorded run instead of the menu,
+	// --seed HEX (as shown in game) sets the first game's seed,
+	// --pack FILE plays the levels of a maze pack instead of generated mazes,
+	// from --level N on
+	uint64_t argSeed = 0;
+	bool haveSeed = false;
+	int argWidth = 0, argHeight = 0, argCell = 0, argParticles = 100, argFps = 60, argLevel = 0;
+	for (int i = 1; i + 1 < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--size") {
+			sscanf(argv[++i], "%dx%d", &argWidth, &argHeight);
+			// Smaller than 3x3 leaves no room for the drains and the start and exit
+			if (argWidth > 0) {
+				argWidth = max(3, argWidth);
+				argHeight = max(3, argHeight);
 			}
 		}
+		else if (arg == "--cell") argCell = atoi(argv[++i]);
+		else if (arg == "--gen") ParseMazeAlgorithm(argv[++i], game.algorithm);
+		else if (arg == "--particles") argParticles = max(0, atoi(argv[++i]));
+		else if (arg == "--rivals") game.rivalCount = max(0, atoi(argv[++i]));
+		else if (arg == "--fps") argFps = max(0, atoi(argv[++i]));
+		else if (arg == "--replay") playingBack = playback.Load(argv[++i]);
+		else if (arg == "--seed") {
+			argSeed = strtoull(argv[++i], nullptr, 16);
+			haveSeed = true;
+		}
+		else if (arg == "--pack") {
+			const char* file = argv[++i];
+			if (!game.OpenPack(file)) TraceLog(LOG_WARNING, "Could not open maze pack %s", file);
+		}
+		else if (arg == "--level") argLevel = max(0, atoi(argv[++i]));
 	}
-}
+	int menuSize = 0;
 
-int main() {
-	srand(time(0));
+	// Seed for the next new game: --seed once, then fresh ones
+	auto nextSeed = [&]() {
+		if (!haveSeed) return seedRng.Next();
+		haveSeed = false;
+		return argSeed;
+	};
+
+	// What Start on the menu plays at this window size
+	auto menuConfig = [&](int screenW, int screenH) {
+		MazeConfig config;
+		config.width = argWidth > 0 ? argWidth : menuMazeSizes[menuSize];
+		config.height = argHeight > 0 ? argHeight : menuMazeSizes[menuSize];
+		config.cellSize = argCell > 0 ? argCell : FitCellSize(config.width, config.height, screenW, screenH);
+		return config;
+	};
+
+	// Generated mazes come ready made from here, for game.config
+	MazeQueue mazeQueue(seedRng.Next());
+
+	int packTried = 0;  // pack level newFloodGame() was last asked for, never -1
+
+	// A new flood game: that level of the pack if there is one (wrapping round
+	// after the last), otherwise a generated maze
+	auto newFloodGame = [&](int level) {
+		if (game.pack.Count() == 0) {
+			unique_ptr<PreparedMaze> maze;
+			if (!haveSeed) maze = mazeQueue.Take(game.config, game.algorithm);
+			if (maze) {
+				game.Start(*maze);
+				mazeQueue.Recycle(move(maze));
+			}
+			else game.NewGame(nextSeed()); // not made yet, or --seed
+			mazeQueue.Configure(game.config, game.algorithm);
+			return;
+		}
+		level %= game.pack.Count();
+		packTried = level;
+		if (game.pack.LevelValid(level)) {
+			const MazePackLevel& info = game.pack.Level(level);
+			game.config.cellSize = argCell > 0 ? argCell : FitCellSize(info.width, info.height, GetScreenWidth(), GetScreenHeight());
+		}
+		// A damaged level gets a generated maze instead; packTried still says
+		// which level it stood in for, so retry and next carry on from there
+		if (!game.NewPackGame(level)) game.NewGame(nextSeed());
+	};
 
 	const int screenWidth = 800;
 	const int screenHeight = 600;
 	SetConfigFlags(FLAG_WINDOW_RESIZABLE);
 	InitWindow(screenWidth, screenHeight, "Maze Master - Flood Escape");
-	SetTargetFPS(60);
-
-	float loadProgress = 0.0f;
-	bool loadingDone = false;
-	float waitTimer = 0.0f;
+	SetTargetFPS(argFps);
 
 	ParticleSystem particles;
-	particles.Init(100, screenWidth, screenHeight);
+	particles.Init(argParticles, screenWidth, screenHeight, seedRng.Next());
 
 	InitAudioDevice();
-	Music bgmusic = LoadMusicStream("music.mp3");
-	PlayMusicStream(bgmusic);
-	SetMusicVolume(bgmusic, 1.0f);
 
-	Texture2D button = LoadTexture("maze_master.png");
-	Texture2D button1 = LoadTexture("newbutstart.png");
-	Texture2D button2 = LoadTexture("newbutabout.png");
-	Texture2D button3 = LoadTexture("nerbutexit.png");
+	// The first flood game's maze is picked while loading, at the size Start
+	// would give it now. Its seed is only used up when that game starts.
+	AssetLoader loader;
+	bool pickFirstMaze = !playingBack && game.pack.Count() == 0;
+	uint64_t firstSeed = haveSeed ? argSeed : seedRng.Next();
+	loader.Start(pickFirstMaze, menuConfig(screenWidth, screenHeight), game.algorithm, firstSeed, game.threads);
 
 	Color border = { 0, 255, 180, 200 };
 
-	vector<Cell> grid(width * height);
-	vector<int> stack;
-
-	// Game objects
-	Player2D player;
-	WaterSystem waterSystem;
-	float gameTimer = 0;
-	bool hasWon = false;
-	int state = 0;
-
-	// Loading screen loop
-	while (!WindowShouldClose() && !loadingDone) {
-		UpdateMusicStream(bgmusic);
+	// Loading screen loop, until the loader is done
+	while (!WindowShouldClose() && !loader.Done()) {
+		loader.Poll();
+		UpdateMusicStream(loader.music);
 
 		int currentW = GetScreenWidth();
 		int currentH = GetScreenHeight();
 		particles.Resize(currentW, currentH);
 
-		if (loadProgress < 100.0f) {
-			loadProgress += 0.8f;
-			if (loadProgress > 100.0f) loadProgress = 100.0f;
-		}
-		else {
-			waitTimer += GetFrameTime();
-			if (waitTimer > 2.0f) loadingDone = true;
-		}
-
 		particles.Update();
 
 		BeginDrawing();
@@ -598,26 +1005,68 @@ int main() {
 
 		DrawRectangle(barX - 2, barY - 2, barW + 4, barH + 4, barBorder);
 		DrawRectangle(barX, barY, barW, barH, barBg);
-		DrawRectangle(barX, barY, (int)(barW * loadProgress / 100), barH, barFill);
-		DrawRectangle(barX, barY, (int)(barW * loadProgress / 100), barH / 2,
+		DrawRectangle(barX, barY, (int)(barW * loader.Progress()), barH, barFill);
+		DrawRectangle(barX, barY, (int)(barW * loader.Progress()), barH / 2,
 			Fade(WHITE, 0.2f));
 
-		const char* loadText = (loadProgress < 100) ? "Loading..." : "Ready";
+		const char* loadText = "Loading...";
 		DrawText(loadText,
 			(currentW - MeasureText(loadText, 20)) / 2,
 			barY + 30, 20, textMain);
 
 		EndDrawing();
 	}
+	Texture2D button = loader.textures[0];
+	Texture2D button1 = loader.textures[1];
+	Texture2D button2 = loader.textures[2];
+	Texture2D button3 = loader.textures[3];
+	Music bgmusic = loader.music;
+	bool firstMazeReady = loader.MazeReady();
+
+	if (playingBack) {
+		// Straight into the recorded run
+		if (playback.mode == ReplayMode::Flood) {
+			playingBack = game.NewGame(playback); // false if its maze pack is gone
+			if (playingBack) state = 1;
+			else TraceLog(LOG_WARNING, "Could not open maze pack %s", playback.packPath.c_str());
+		}
+		else {
+			endless.NewGame(playback);
+			state = 4;
+		}
+		clock.Reset();
+	}
 
 	// Main game loop
+	Profiler& profiler = Profiler::Get();
+	profiler.enabled = true;
+	bool showProfiler = false;
 	while (!WindowShouldClose()) {
-		UpdateMusicStream(bgmusic);
+		// Last frame's zones into the overlay stats, then this frame's zones start
+		profiler.EndFrame();
+		ProfileScope frameZone(PROFILE_FRAME);
+		if (IsKeyPressed(KEY_F3)) showProfiler = !showProfiler;
+		if (IsKeyPressed(KEY_F4)) {
+			if (!profiler.SaveCsv("profile.csv") || !profiler.SaveChromeTrace("profile.json")) {
+				TraceLog(LOG_WARNING, "Could not write the profile");
+			}
+		}
+
+		{
+			ProfileScope zone(PROFILE_MUSIC);
+			UpdateMusicStream(bgmusic);
+		}
 
 		int currentW = GetScreenWidth();
 		int currentH = GetScreenHeight();
 		particles.Resize(currentW, currentH);
-		particles.Update();
+
+		// Whole ticks due since the last frame; 0 to several depending on the frame rate
+		int ticksDue = clock.Advance(GetFrameTime());
+		{
+			ProfileScope zone(PROFILE_PARTICLES_UPDATE);
+			for (int t = 0; t < ticksDue; t++) particles.Update();
+		}
 
 		if (state == 0) {
 			Vector2 mousePos = GetMousePosition();
@@ -639,6 +1088,19 @@ int main() {
 			};
 
 			if (IsKeyPressed(KEY_F)) ToggleFullscreen();
+			if (IsKeyPressed(KEY_RIGHT_BRACKET)) menuSize = (menuSize + 1) % menuMazeSizeCount;
+			if (IsKeyPressed(KEY_LEFT_BRACKET)) menuSize = (menuSize + menuMazeSizeCount - 1) % menuMazeSizeCount;
+			if (IsKeyPressed(KEY_G)) game.algorithm = (MazeAlgorithm)(((int)game.algorithm + 1) % (int)MazeAlgorithm::Count);
+			// Start's maze gets made while the menu is up (the first one already was)
+			if (!firstMazeReady && game.pack.Count() == 0) mazeQueue.Configure(menuConfig(currentW, currentH), game.algorithm);
+			if (IsKeyPressed(KEY_E)) {
+				state = 4;
+				endless.config.width = argWidth > 0 ? argWidth : 20;
+				endless.config.cellSize = argCell > 0 ? argCell : 20;
+				endless.NewGame(nextSeed());
+				clock.Reset();
+				runSaved = false;
+			}
 
 			BeginDrawing();
 			DrawGradientBackground(currentW, currentH);
@@ -652,11 +1114,21 @@ int main() {
 			if (CheckCollisionPointRec(mousePos, rec)) {
 				if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
 					state = 1;
-					maze_generation(grid, stack);
-					player.Reset();
-					waterSystem.Reset();
-					gameTimer = 0;
-					hasWon = false;
+					game.config = menuConfig(currentW, currentH);
+					if (firstMazeReady) {
+						// Picked while loading; if the size or generator changed since, just its seed is used
+						PreparedMaze& first = loader.firstMaze;
+						bool same = first.config.width == game.config.width && first.config.height == game.config.height
+							&& first.config.cellSize == game.config.cellSize && first.algorithm == game.algorithm;
+						if (same) game.Start(first);
+						else game.NewGame(first.seed);
+						if (haveSeed && first.seed == argSeed) haveSeed = false;
+						firstMazeReady = false;
+						mazeQueue.Configure(game.config, game.algorithm);
+					}
+					else newFloodGame(argLevel);
+					clock.Reset();
+					runSaved = false;
 				}
 				DrawRectangleLinesEx(rec, 3.0f, border);
 			}
@@ -673,122 +1145,122 @@ int main() {
 				DrawRectangleLinesEx(rec3, 3.0f, border);
 			}
 
+			const char* sizeText = game.pack.Count() > 0
+				? TextFormat("Maze pack: %d levels", game.pack.Count())
+				: argWidth > 0
+				? TextFormat("Maze size: %dx%d", argWidth, argHeight)
+				: TextFormat("Maze size: %dx%d   ([ / ] to change)", menuMazeSizes[menuSize], menuMazeSizes[menuSize]);
+			DrawText(sizeText, (currentW - MeasureText(sizeText, 18)) / 2,
+				(int)rec.y + (int)rec.height + 30, 18, textMain);
+			const char* genText = TextFormat("Generator: %s   (G to change)", MazeAlgorithmName(game.algorithm));
+			DrawText(genText, (currentW - MeasureText(genText, 18)) / 2,
+				(int)rec.y + (int)rec.height + 55, 18, textMain);
+			DrawText("Press E for ENDLESS FLOOD",
+				(currentW - MeasureText("Press E for ENDLESS FLOOD", 18)) / 2,
+				(int)rec.y + (int)rec.height + 80, 18, textAccent);
+
 			DrawText("Press F for Fullscreen",
 				(currentW - MeasureText("Press F for Fullscreen", 16)) / 2,
 				currentH - 40, 16, Fade(textMain, 0.7f));
 
-			EndDrawing();
+			Present(showProfiler);
 		}
 
 		else if (state == 1) {
-			gameTimer += GetFrameTime();
-
-			if (!waterSystem.IsGameOver() && !hasWon) {
-				player.Update(grid);
-				waterSystem.Update(player.x, player.y, GetFrameTime());
-				hasWon = player.HasReachedExit();
+			if (IsKeyPressed(KEY_H)) showHint = !showHint;
+			if (IsKeyPressed(KEY_M)) showMinimap = !showMinimap;
+			if (IsKeyPressed(KEY_P)) {
+				autoSolve = !autoSolve;
+				solverBot.Reset(game.player);
 			}
+			uint8_t keys = ReadPlayerInput();
+			{
+				ProfileScope zone(PROFILE_TICKS);
+				for (int t = 0; t < ticksDue; t++) {
+					if (game.ticks == 0) solverBot.Reset(game.player); // fresh maze
+					if (playingBack) game.Step(playback.InputAt(game.ticks));
+					else game.Step(autoSolve ? solverBot.NextInput(game.player, game.solver) : keys);
+					minimap.Track(game);
+				}
+			}
+			if (game.IsOver() && !playingBack) SaveRun(game, runSaved);
+			float alpha = game.IsOver() ? 1.0f : clock.Alpha();
+			camera.Update(game.player.DrawX(alpha), game.player.DrawY(alpha), game, currentW, currentH);
+			CellRect visible = camera.Visible(game, currentW, currentH);
+			mazeLayer.Update(game, visible);
+			minimap.Upload(game);
 
 			BeginDrawing();
 			DrawGradientBackground(currentW, currentH);
 			particles.Draw();
 
-			// Calculate maze offset to center it
-			int mazeWidth = width * CELL_SIZE;
-			int mazeHeight = height * CELL_SIZE;
-			int offsetX = (currentW - mazeWidth) / 2;
-			int offsetY = (currentH - mazeHeight) / 2;
+			// The maze is drawn in maze pixels, (0, 0) its top left corner, and the
+			// camera puts the part around the player on screen
+			BeginMode2D(camera.camera);
+			const int cellSize = game.config.cellSize;
+			int mazeWidth = game.grid.cols * cellSize;
+			int mazeHeight = game.grid.rows * cellSize;
 
 			// Draw maze background
-			DrawRectangle(offsetX - 20, offsetY - 20, mazeWidth + 40, mazeHeight + 40,
-				Fade(BLACK, 0.5f));
-			DrawRectangleLinesEx({ (float)(offsetX - 20), (float)(offsetY - 20),
-								  (float)(mazeWidth + 40), (float)(mazeHeight + 40) },
+			DrawRectangle(-20, -20, mazeWidth + 40, mazeHeight + 40, Fade(BLACK, 0.5f));
+			DrawRectangleLinesEx({ -20.0f, -20.0f, (float)(mazeWidth + 40), (float)(mazeHeight + 40) },
 				2.0f, barBorder);
 
-			// Draw maze cells
-			for (int y = 0; y < height; y++) {
-				for (int x = 0; x < width; x++) {
-					int px = offsetX + x * CELL_SIZE;
-					int py = offsetY + y * CELL_SIZE;
-					DrawRectangle(px, py, CELL_SIZE, CELL_SIZE, Fade(purpleTop, 0.2f));
-				}
-			}
-
-			// Draw maze walls
-			Color wallColor = { 200, 180, 255, 255 };
-			for (int y = 0; y < height; y++) {
-				for (int x = 0; x < width; x++) {
-					int px = offsetX + x * CELL_SIZE;
-					int py = offsetY + y * CELL_SIZE;
-					int idx = index(x, y);
-
-					if (grid[idx].walls[0])
-						DrawLineEx({ (float)px, (float)py },
-							{ (float)(px + CELL_SIZE), (float)py }, 2.0f, wallColor);
-					if (grid[idx].walls[1])
-						DrawLineEx({ (float)px, (float)(py + CELL_SIZE) },
-							{ (float)(px + CELL_SIZE), (float)(py + CELL_SIZE) }, 2.0f, wallColor);
-					if (grid[idx].walls[2])
-						DrawLineEx({ (float)px, (float)py },
-							{ (float)px, (float)(py + CELL_SIZE) }, 2.0f, wallColor);
-					if (grid[idx].walls[3])
-						DrawLineEx({ (float)(px + CELL_SIZE), (float)py },
-							{ (float)(px + CELL_SIZE), (float)(py + CELL_SIZE) }, 2.0f, wallColor);
-				}
-			}
+			// Draw maze cells (one rectangle, they're all the same colour) and the cached walls
+			DrawRectangle(0, 0, mazeWidth, mazeHeight, Fade(purpleTop, 0.2f));
+			mazeLayer.Draw(game, visible);
 
-			DrawRectangle(offsetX + 5, offsetY + 5, CELL_SIZE - 10, CELL_SIZE - 10,
-				Fade(BLUE, 0.3f));
-			DrawText("START", offsetX + 7, offsetY + CELL_SIZE / 2 - 5, 10, BLUE);
+			DrawRectangle(5, 5, cellSize - 10, cellSize - 10, Fade(BLUE, 0.3f));
+			DrawText("START", 7, cellSize / 2 - 5, 10, BLUE);
 
-			float exitX = (width - 1) * CELL_SIZE + CELL_SIZE / 2;
-			float exitY = (height - 1) * CELL_SIZE + CELL_SIZE / 2;
-			DrawCircle(offsetX + exitX, offsetY + exitY, CELL_SIZE / 3, Fade(GREEN, 0.3f));
-			DrawCircle(offsetX + exitX, offsetY + exitY, CELL_SIZE / 4, GREEN);
-			DrawText("EXIT", offsetX + exitX - 12, offsetY + exitY - 5, 10, WHITE);
+			float exitX = (game.grid.cols - 1) * cellSize + cellSize / 2;
+			float exitY = (game.grid.rows - 1) * cellSize + cellSize / 2;
+			DrawCircle(exitX, exitY, cellSize / 3, Fade(GREEN, 0.3f));
+			DrawCircle(exitX, exitY, cellSize / 4, GREEN);
+			DrawText("EXIT", exitX - 12, exitY - 5, 10, WHITE);
 
-			waterSystem.Draw(offsetX, offsetY);
+			DrawWater(game.waterSystem, alpha, visible);
 
-			player.Draw(offsetX, offsetY, waterSystem.isPlayerUnderwater);
+			{
+				ProfileScope zone(PROFILE_ACTORS_DRAW);
+				zone.Draws(3 + game.rivals.count);
+				if (showHint || autoSolve) DrawHint(game.player, alpha, game.solver, 0, 0);
+				DrawRivals(game.rivals, alpha, visible, cellSize);
+				DrawPlayer(game.player, alpha, 0, 0, game.waterSystem.isPlayerUnderwater);
+			}
+			EndMode2D();
+			// Only worth the corner while part of the maze is off screen
+			bool mazeOnScreen = visible.x0 == 0 && visible.y0 == 0 && visible.x1 == game.grid.cols && visible.y1 == game.grid.rows;
+			if (showMinimap && !mazeOnScreen) minimap.Draw(game, alpha, visible, currentW, currentH);
 
 			DrawRectangle(0, 0, currentW, 60, Fade(BLACK, 0.5f));
 			DrawText("FLOOD ESCAPE",
 				(currentW - MeasureText("FLOOD ESCAPE", 36)) / 2,
 				10, 36, textAccent);
 
-			DrawText(TextFormat("Time: %.1fs", gameTimer), currentW - 120, 10, 16, WHITE);
-			DrawText(TextFormat("Water: %.0f%%", waterSystem.GetWaterPercentage()),
+			DrawText(TextFormat("Time: %.1fs", game.gameTimer), currentW - 120, 10, 16, WHITE);
+			if (playingBack) DrawText("REPLAY", 10, 10, 20, RED);
+			if (game.packLevel >= 0) {
+				DrawText(TextFormat("Level %d: %s", game.packLevel + 1, game.pack.Name(game.packLevel).c_str()),
+					10, 38, 14, Fade(WHITE, 0.6f));
+			}
+			else DrawSeed(game.seed);
+			DrawText(TextFormat("Water: %.0f%%", game.waterSystem.GetWaterPercentage()),
 				currentW - 120, 30, 16, BLUE);
+			if (game.rivals.count > 0) {
+				DrawText(TextFormat("Rivals: %d out, %d drowned", game.rivals.escaped, game.rivals.drowned),
+					10, 70, 16, Color{ 255, 120, 180, 255 });
+			}
 
-			waterSystem.DrawUI(currentW, currentH);
+			DrawWaterUI(game.waterSystem, currentW, currentH);
 
-			DrawText("WASD/Arrows: Move | Collect AIR BUBBLES | Activate DRAINS | Reach EXIT",
-				(currentW - MeasureText("WASD/Arrows: Move | Collect AIR BUBBLES | Activate DRAINS | Reach EXIT", 14)) / 2,
+			DrawText("WASD/Arrows: Move | Collect AIR BUBBLES | Activate DRAINS | Reach EXIT | H: Hint | P: Auto-solve | M: Map | C: Copy seed",
+				(currentW - MeasureText("WASD/Arrows: Move | Collect AIR BUBBLES | Activate DRAINS | Reach EXIT | H: Hint | P: Auto-solve | M: Map | C: Copy seed", 14)) / 2,
 				currentH - 30, 14, textMain);
 
-			if (waterSystem.IsGameOver()) {
+			if (game.waterSystem.IsGameOver()) {
 				
-				for (int y = 0; y < GetScreenHeight()/2; y++) {
-					float t = (float)y / GetScreenHeight();
-					Color lineCol = {
-						(purpleTop.r* (1 - t) + blackBottom.r * t),
-						(purpleTop.g* (1 - t) + blackBottom.g * t),
-						(purpleTop.b* (1 - t) + blackBottom.b * t),
-						255
-					};
-					DrawLine(0, y, GetScreenWidth(), y, lineCol);
-				}
-				for (int y = GetScreenHeight(); y >= GetScreenHeight()/2; y--) {
-					float	t = (float)y / GetScreenHeight();
-					Color lineCol = {
-						(purpleTop.r * (1 - t) + blackBottom.r * t),
-						(purpleTop.g * (1 - t) + blackBottom.g * t),
-						(purpleTop.b * (1 - t) + blackBottom.b * t),
-						255
-					};
-					DrawLine(0, y, GetScreenWidth(), y, lineCol);
-				}
+				DrawGradientBackground(currentW, currentH);
 				DrawRectangle(currentW / 2 - 200, currentH / 2 - 80, 400, 160, Fade(BLACK, 0.8f));
 				DrawText("GAME OVER",
 					(currentW - MeasureText("GAME OVER", 40)) / 2,
@@ -801,41 +1273,42 @@ int main() {
 					currentH / 2 + 30, 16, textMain);
 
 				if (IsKeyPressed(KEY_ENTER)) {
-					maze_generation(grid, stack);
-					player.Reset();
-					waterSystem.Reset();
-					gameTimer = 0;
-					hasWon = false;
+					if (playingBack) game.NewGame(playback); // watch it again
+					else newFloodGame(packTried); // pack levels are retried, mazes are new
+					clock.Reset();
+					runSaved = false;
 				}
 			}
 
 			// Win screen
-			if (hasWon) {
+			if (game.hasWon) {
 				DrawRectangle(currentW / 2 - 200, currentH / 2 - 80, 400, 160, Fade(BLACK, 0.8f));
 				DrawText("YOU ESCAPED!",
 					(currentW - MeasureText("YOU ESCAPED!", 40)) / 2,
 					currentH / 2 - 60, 40, GREEN);
-				DrawText(TextFormat("Time: %.1f seconds", gameTimer),
-					(currentW - MeasureText(TextFormat("Time: %.1f seconds", gameTimer), 20)) / 2,
-					currentH / 2 - 10, 20, WHITE);
+				const char* result = game.rivals.count > 0
+					? TextFormat("Time: %.1f seconds - place %d of %d", game.gameTimer, game.rivals.escaped + 1, game.rivals.count + 1)
+					: TextFormat("Time: %.1f seconds", game.gameTimer);
+				DrawText(result, (currentW - MeasureText(result, 20)) / 2, currentH / 2 - 10, 20, WHITE);
 				DrawText("Press ENTER for new maze or TAB for menu",
 					(currentW - MeasureText("Press ENTER for new maze or TAB for menu", 16)) / 2,
 					currentH / 2 + 30, 16, textMain);
 
 				if (IsKeyPressed(KEY_ENTER)) {
-					maze_generation(grid, stack);
-					player.Reset();
-					waterSystem.Reset();
-					gameTimer = 0;
-					hasWon = false;
+					if (playingBack) game.NewGame(playback); // watch it again
+					else newFloodGame(packTried + 1);
+					clock.Reset();
+					runSaved = false;
 				}
 			}
 
 			if (IsKeyPressed(KEY_TAB)) {
+				if (!playingBack) SaveRun(game, runSaved);
+				playingBack = false;
 				state = 0;
 			}
 
-			EndDrawing();
+			Present(showProfiler);
 		}
 
 		else if (state == 2) {
@@ -899,14 +1372,64 @@ int main() {
 
 			if (IsKeyPressed(KEY_TAB)) state = 0;
 
-			EndDrawing();
+			Present(showProfiler);
 		}
 
 		else if (state == 3) {
 			break;
 		}
+
+		else if (state == 4) {
+			uint8_t keys = ReadPlayerInput();
+			{
+				ProfileScope zone(PROFILE_TICKS);
+				for (int t = 0; t < ticksDue; t++) endless.Step(playingBack ? playback.InputAt(endless.ticks) : keys);
+			}
+			if (endless.IsOver() && !playingBack) SaveRun(endless, runSaved);
+			float alpha = endless.IsOver() ? 1.0f : clock.Alpha();
+
+			BeginDrawing();
+			DrawGradientBackground(currentW, currentH);
+			particles.Draw();
+			DrawEndless(endless, alpha, currentW, currentH);
+			if (playingBack) DrawText("REPLAY", 10, 10, 20, RED);
+			DrawSeed(endless.seed);
+
+			if (endless.IsOver()) {
+				DrawRectangle(currentW / 2 - 200, currentH / 2 - 80, 400, 160, Fade(BLACK, 0.8f));
+				DrawText("GAME OVER",
+					(currentW - MeasureText("GAME OVER", 40)) / 2,
+					currentH / 2 - 60, 40, RED);
+				const char* heightText = TextFormat("You climbed %d rows", endless.RowsClimbed());
+				DrawText(heightText,
+					(currentW - MeasureText(heightText, 20)) / 2,
+					currentH / 2 - 10, 20, WHITE);
+				DrawText("Press ENTER to retry or TAB for menu",
+					(currentW - MeasureText("Press ENTER to retry or TAB for menu", 16)) / 2,
+					currentH / 2 + 30, 16, textMain);
+
+				if (IsKeyPressed(KEY_ENTER)) {
+					if (playingBack) endless.NewGame(playback);
+					else endless.NewGame(nextSeed());
+					clock.Reset();
+					runSaved = false;
+				}
+			}
+
+			if (IsKeyPressed(KEY_TAB)) {
+				if (!playingBack) SaveRun(endless, runSaved);
+				playingBack = false;
+				state = 0;
+			}
+
+			Present(showProfiler);
+		}
 	}
 
+	mazeLayer.Unload();
+	minimap.Unload();
+	gradientCache.Unload();
+	particles.Unload();
 	UnloadMusicStream(bgmusic);
 	CloseAudioDevice();
 	UnloadTexture(button);
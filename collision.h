@@ -0,0 +1,97 @@
+#pragma once
+// Circle-vs-maze collision for everything that moves: the player, and any
+// number of other bodies in one batch. Moves longer than a fraction of a cell
+// are cut into substeps so fast bodies can't skip over a wall. No raylib in here.
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "maze.h"
+#include "parallel.h"
+
+// Does a circle of radius r centred at (x, y) fit where it is? Works on
+// MazeView and on the endless ring (rows from FirstRow() to EndRow()).
+template <class Grid>
+bool CircleFits(const Grid& grid, int cellSize, float x, float y, float r) {
+	// Geting grid position (floor, rows can be negative in endless mode)
+	int gridX = (int)floor(x / cellSize);
+	int gridY = (int)floor(y / cellSize);
+
+	// Checking th boundary
+	if (x < r || x > grid.cols * cellSize - r) return false;
+	if (y < grid.FirstRow() * cellSize + r || y > grid.EndRow() * cellSize - r) return false;
+
+	if (gridX < 0 || gridX >= grid.cols || gridY < grid.FirstRow() || gridY >= grid.EndRow()) return false;
+
+	// Position inside the cell against the walls it has
+	float cellX = x - gridX * cellSize;
+	float cellY = y - gridY * cellSize;
+
+	if (cellY < r && grid.HasWall(gridX, gridY, WALL_TOP)) return false;
+	if (cellY > cellSize - r && grid.HasWall(gridX, gridY, WALL_BOTTOM)) return false;
+	if (cellX < r && grid.HasWall(gridX, gridY, WALL_LEFT)) return false;
+	if (cellX > cellSize - r && grid.HasWall(gridX, gridY, WALL_RIGHT)) return false;
+
+	return true;
+}
+
+// Moves one circle by (dx, dy), in substeps of at most maxStep on either axis.
+// Each substep tries the full step, then slides along x, then along y.
+template <class Grid>
+void MoveCircle(const Grid& grid, int cellSize, float& x, float& y, float r, float dx, float dy, float maxStep) {
+	float longest = std::max(fabsf(dx), fabsf(dy));
+	int steps = longest > maxStep ? (int)ceilf(longest / maxStep) : 1;
+	float sx = dx / steps, sy = dy / steps;
+
+	for (int i = 0; i < steps; i++) {
+		float newX = x + sx, newY = y + sy;
+		if (CircleFits(grid, cellSize, newX, newY, r)) {
+			x = newX;
+			y = newY;
+		}
+		else if (CircleFits(grid, cellSize, newX, y, r)) x = newX;
+		else if (CircleFits(grid, cellSize, x, newY, r)) y = newY;
+		else break; // stuck in a corner, the rest of the move won't go anywhere either
+	}
+}
+
+// A batch of circles and the move each wants this tick, structure-of-arrays.
+// ResolveMoves writes the positions they actually end up at back into x, y.
+class BodyBatch {
+public:
+	std::vector<float> x, y;
+	std::vector<float> radius;
+	std::vector<float> moveX, moveY;
+
+	int Count() const { return (int)x.size(); }
+
+	int Add(float px, float py, float r) {
+		x.push_back(px);
+		y.push_back(py);
+		radius.push_back(r);
+		moveX.push_back(0);
+		moveY.push_back(0);
+		return Count() - 1;
+	}
+
+	void Clear() {
+		x.clear(); y.clear();
+		radius.clear();
+		moveX.clear(); moveY.clear();
+	}
+};
+
+// Bodies don't collide with each other, only with walls, so big batches are
+// split into chunks across threads
+template <class Grid>
+void ResolveMoves(const Grid& grid, int cellSize, BodyBatch& bodies, float maxStep, int threads = 1) {
+	const int CHUNK = 4096;
+	const int count = bodies.Count();
+	const int chunks = (count + CHUNK - 1) / CHUNK;
+	ParallelFor(chunks, threads, [&](int chunk, int) {
+		int end = std::min(count, (chunk + 1) * CHUNK);
+		for (int i = chunk * CHUNK; i < end; i++) {
+			MoveCircle(grid, cellSize, bodies.x[i], bodies.y[i], bodies.radius[i],
+				bodies.moveX[i], bodies.moveY[i], maxStep);
+		}
+	});
+}
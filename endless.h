@@ -0,0 +1,237 @@
+#pragma once
+// Endless flood mode: the maze is generated one row at a time (Eller's algorithm)
+// above the player and forgotten below, so memory stays O(width) no matter how
+// high the player climbs.
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include "maze.h"
+#include "rng.h"
+#include "sim.h"
+
+// Fixed number of live maze rows, indexed by absolute row number (rows go
+// negative as the maze grows upward). Same 2-bit right/bottom layout as MazeGrid,
+// so it works with the same collision code. Rows are recycled in place.
+class MazeRowRing {
+public:
+	int cols = 0;
+	int wordsPerRow = 0;
+	int capacity = 0;   // power of two
+	int topRow = 0;     // newest (highest) live row
+	int rowCount = 0;
+	std::vector<uint64_t> words;
+
+	void Init(int c, int capacityRows) {
+		cols = c;
+		wordsPerRow = (c * 2 + 63) / 64;
+		capacity = 1;
+		while (capacity < capacityRows) capacity <<= 1;
+		words.assign((size_t)capacity * wordsPerRow, ~0ull);
+		topRow = 1;
+		rowCount = 0;
+	}
+
+	// Row bounds, same names CircleFits uses on MazeView
+	int FirstRow() const { return topRow; }
+	int EndRow() const { return topRow + rowCount; }
+	bool Full() const { return rowCount == capacity; }
+
+	uint64_t* Row(int row) { return &words[(size_t)(row & (capacity - 1)) * wordsPerRow]; }
+	const uint64_t* Row(int row) const { return &words[(size_t)(row & (capacity - 1)) * wordsPerRow]; }
+
+	// Makes room for one more row on top and returns it, all walls set.
+	// When the ring is full the bottom row is dropped.
+	uint64_t* PushTop() {
+		if (Full()) rowCount--;
+		topRow--;
+		rowCount++;
+		uint64_t* row = Row(topRow);
+		std::fill(row, row + wordsPerRow, ~0ull);
+		return row;
+	}
+
+	int WallBits(int x, int y) const {
+		return (Row(y)[x >> 5] >> ((x & 31) * 2)) & 3;
+	}
+
+	bool HasWall(int x, int y, int side) const {
+		switch (side) {
+		case WALL_TOP: return y == topRow || (WallBits(x, y - 1) & 2);
+		case WALL_BOTTOM: return y == EndRow() - 1 || (WallBits(x, y) & 2);
+		case WALL_LEFT: return x == 0 || (WallBits(x - 1, y) & 1);
+		default: return WallBits(x, y) & 1;
+		}
+	}
+};
+
+// Eller's algorithm, emitting rows upward. Only the set id of each cell in the
+// newest row is kept, plus a per-row union-find over at most 2*cols ids.
+class EllerGenerator {
+public:
+	int cols = 0;
+	bool started = false;
+	std::vector<int> sets;     // set id (0..cols-1) per column of the newest row
+	std::vector<int> rowIds;   // ids of the row being built (inherited or fresh)
+	std::vector<int> parent;   // union-find over those ids
+	std::vector<int> remap;
+	std::vector<int> members;  // cells of each set seen so far
+	std::vector<int> pick;     // random member of each set (reservoir sample)
+
+	void Reset(int c) {
+		cols = c;
+		started = false;
+		sets.assign(cols, 0);
+		rowIds.assign(cols, 0);
+		parent.assign(cols * 2, 0);
+		remap.assign(cols * 2, -1);
+		members.assign(cols, 0);
+		pick.assign(cols, 0);
+	}
+
+	int Find(int a) {
+		while (parent[a] != a) {
+			parent[a] = parent[parent[a]];
+			a = parent[a];
+		}
+		return a;
+	}
+
+	// Fills row (all walls set on entry) as the row above the previous one
+	void NextRow(uint64_t* row, Rng& rng) {
+		for (int i = 0; i < cols * 2; i++) parent[i] = i;
+
+		if (!started) {
+			// First row: every cell is its own set, floor stays closed
+			for (int x = 0; x < cols; x++) rowIds[x] = cols + x;
+			started = true;
+		}
+		else {
+			// Every set of the previous row gets at least one passage up into this row
+			std::fill(members.begin(), members.end(), 0);
+			for (int x = 0; x < cols; x++) {
+				int s = sets[x];
+				if (rng.Below(members[s] + 1) == 0) pick[s] = x;
+				members[s]++;
+			}
+			for (int x = 0; x < cols; x++) {
+				int s = sets[x];
+				if (pick[s] == x || (rng.Next() & 1)) {
+					row[x >> 5] &= ~(1ull << ((x & 31) * 2 + 1)); // bottom wall of the new row
+					rowIds[x] = s;
+				}
+				else {
+					rowIds[x] = cols + x;
+				}
+			}
+		}
+
+		// Randomly join neighbours that aren't connected yet
+		for (int x = 0; x + 1 < cols; x++) {
+			int a = Find(rowIds[x]), b = Find(rowIds[x + 1]);
+			if (a != b && (rng.Next() & 1)) {
+				parent[b] = a;
+				row[x >> 5] &= ~(1ull << ((x & 31) * 2)); // right wall
+			}
+		}
+
+		// Compact the surviving set ids back into 0..cols-1
+		std::fill(remap.begin(), remap.end(), -1);
+		int nextId = 0;
+		for (int x = 0; x < cols; x++) {
+			int root = Find(rowIds[x]);
+			if (remap[root] < 0) remap[root] = nextId++;
+			sets[x] = remap[root];
+		}
+	}
+};
+
+// The endless run: climb the streaming maze ahead of water that never stops rising.
+class EndlessGame {
+public:
+	static const int RING_ROWS = 64;   // live rows kept in memory
+	static const int ROWS_AHEAD = 40;  // generated above the player; the rest stay below
+
+	MazeConfig config;  // width and cellSize; height isn't used
+	MazeRowRing ring;
+	EllerGenerator eller;
+	Rng rng;
+	Player2D player;
+	float waterTopY = 0;
+	float prevWaterTopY = 0;  // before the last tick, for drawing between ticks
+	float riseSpeed = 0.3f;
+	float oxygenLevel = 100.0f;
+	float oxygenDepletionRate = 0.15f;
+	bool isPlayerUnderwater = false;
+	int bestRow = 0;
+	int ticks = 0;
+	uint64_t seed = 0;
+	Replay replay;      // the run so far
+
+	void NewGame(uint64_t gameSeed) {
+		seed = gameSeed;
+		rng = Rng(seed, RNG_ENDLESS);
+		ring.Init(config.width, RING_ROWS);
+		eller.Reset(config.width);
+		while (ring.rowCount < ROWS_AHEAD) eller.NextRow(ring.PushTop(), rng);
+
+		player.Reset(config);
+		player.x = (config.width / 2 + 0.5f) * config.cellSize;
+		player.y = 0.5f * config.cellSize; // row 0, the floor row
+		player.prevX = player.x;
+		player.prevY = player.y;
+
+		waterTopY = prevWaterTopY = config.cellSize * 3.0f; // starts a few rows below the floor
+		riseSpeed = config.cellSize * 0.015f;
+		oxygenLevel = 100.0f;
+		isPlayerUnderwater = false;
+		bestRow = 0;
+		ticks = 0;
+		replay.Begin(ReplayMode::Endless, config, MazeAlgorithm::Backtracker, 0, seed);
+	}
+
+	void NewGame(const Replay& from) {
+		config = from.config;
+		NewGame(from.seed);
+	}
+
+	uint32_t StateHash() const {
+		uint32_t h = 2166136261u;
+		h = HashBytes(h, &player.x, sizeof(float));
+		h = HashBytes(h, &player.y, sizeof(float));
+		h = HashBytes(h, &oxygenLevel, sizeof(float));
+		h = HashBytes(h, &waterTopY, sizeof(float));
+		return h;
+	}
+
+	bool IsOver() const { return oxygenLevel <= 0; }
+	int RowsClimbed() const { return -bestRow; }
+	float DrawWaterTopY(float alpha) const { return prevWaterTopY + (waterTopY - prevWaterTopY) * alpha; }
+
+	void Step(uint8_t input) {
+		if (IsOver()) return;
+		replay.inputs.push_back(input);
+
+		player.Update(input, ring);
+		int row = (int)floor(player.y / config.cellSize);
+		if (row < bestRow) bestRow = row;
+
+		// Keep the maze ahead of the player; full ring recycles the bottom row
+		while (ring.topRow > row - ROWS_AHEAD) eller.NextRow(ring.PushTop(), rng);
+
+		// Water speeds up a little every minute
+		prevWaterTopY = waterTopY;
+		waterTopY -= riseSpeed * (1.0f + ticks / (TICK_RATE * 60.0f) * 0.25f);
+
+		isPlayerUnderwater = player.y > waterTopY;
+		if (isPlayerUnderwater) {
+			oxygenLevel -= oxygenDepletionRate;
+			if (oxygenLevel < 0) oxygenLevel = 0;
+		}
+		else {
+			oxygenLevel += 0.5f;
+			if (oxygenLevel > 100) oxygenLevel = 100;
+		}
+		ticks++;
+		if (ticks % TICK_RATE == 0) replay.checkpoints.push_back(StateHash());
+	}
+};
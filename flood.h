@@ -0,0 +1,144 @@
+#pragma once
+// Cell-based flood: water comes in along the bottom row and spreads cell to cell
+// through open walls, so corridors the water can't reach yet stay dry. Only the
+// cells at the water's edge (the frontier) are touched each tick. No raylib in here.
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "maze.h"
+#include "mazegen.h"
+
+class FloodField {
+public:
+	static const int FULL = 255;
+
+	int cols = 0;
+	int rows = 0;
+	std::vector<uint8_t> depth;   // per cell, 0 dry .. FULL
+	std::vector<int> frontier;    // cells filling up (or draining) right now
+	std::vector<int> filled;      // full cells in the order they filled, drained in reverse
+	BitSet inFrontier;
+	long long volume = 0;         // sum of depth, for the water gauge
+	float pending = 0;            // fraction of a depth unit carried to the next tick
+	int lastStep = 0;             // depth units the frontier moved last tick, signed
+
+	void Reset(int c, int r) {
+		cols = c;
+		rows = r;
+		depth.assign(cols * rows, 0);
+		inFrontier.Resize(cols * rows);
+		frontier.clear();
+		filled.clear();
+		volume = 0;
+		pending = 0;
+		lastStep = 0;
+		for (int x = 0; x < cols; x++) AddToFrontier(x + (rows - 1) * cols);
+	}
+
+	int Depth(int x, int y) const { return depth[x + y * cols]; }
+
+	// Water surface inside a cell as a fraction of the cell height from the top (1 = dry)
+	float Surface(int x, int y) const { return 1.0f - Depth(x, y) / (float)FULL; }
+
+	float Percentage() const { return volume * 100.0f / ((float)cols * rows * FULL); }
+
+	// Depth of a cell for drawing `alpha` of the way from the last tick to this
+	// one. Only the frontier moves between ticks; a cell that filled up this tick
+	// shows as full straight away, which is a few units early at most.
+	float DrawDepth(int cell, float alpha) const {
+		if (!inFrontier.Test(cell)) return depth[cell];
+		return std::min(std::max(depth[cell] - (1 - alpha) * lastStep, 0.0f), (float)FULL);
+	}
+
+	// rate is in depth units per tick for every frontier cell; negative drains
+	template <class Grid>
+	void Update(const Grid& grid, float rate) {
+		pending += rate;
+		int amount = (int)pending;
+		pending -= amount;
+		lastStep = amount;
+		if (amount > 0) Rise(grid, amount);
+		else if (amount < 0) Drain(grid, -amount);
+	}
+
+private:
+	// The frontier is every wet cell that isn't full, plus every dry cell water
+	// can flow into next: open to a full cell, or on the bottom row where the
+	// water comes in.
+	void AddToFrontier(int cell) {
+		if (inFrontier.Test(cell) || depth[cell] == FULL) return;
+		inFrontier.Set(cell);
+		frontier.push_back(cell);
+	}
+
+	void RemoveFromFrontier(size_t i) {
+		inFrontier.Clear(frontier[i]);
+		frontier[i] = frontier.back();
+		frontier.pop_back();
+	}
+
+	template <class Grid>
+	bool CanFlowInto(const Grid& grid, int cell) const {
+		int y = cell / cols, x = cell - y * cols;
+		if (y == rows - 1) return true;
+		for (int side = 0; side < 4; side++) {
+			if (grid.HasWall(x, y, side)) continue;
+			int n = grid.index(x + sideDX[side], y + sideDY[side]);
+			if (n != -1 && depth[n] == FULL) return true;
+		}
+		return false;
+	}
+
+	template <class Grid>
+	void Rise(const Grid& grid, int amount) {
+		// Backwards so swap-remove doesn't skip anything; cells added here land
+		// past the ones still to visit and start filling next tick
+		for (size_t i = frontier.size(); i-- > 0;) {
+			int cell = frontier[i];
+			int d = depth[cell] + amount;
+			if (d < FULL) {
+				volume += amount;
+				depth[cell] = (uint8_t)d;
+				continue;
+			}
+			volume += FULL - depth[cell];
+			depth[cell] = FULL;
+			filled.push_back(cell);
+			RemoveFromFrontier(i);
+
+			int y = cell / cols, x = cell - y * cols;
+			for (int side = 0; side < 4; side++) {
+				if (grid.HasWall(x, y, side)) continue;
+				int n = grid.index(x + sideDX[side], y + sideDY[side]);
+				if (n != -1) AddToFrontier(n);
+			}
+		}
+	}
+
+	// Lowers the frontier. Each cell that runs dry hands over to the last cell
+	// that filled, so about as many cells drain at once as were filling and the
+	// water goes back out the way it came in.
+	template <class Grid>
+	void Drain(const Grid& grid, int amount) {
+		int wet = 0, dried = 0;
+		for (size_t i = frontier.size(); i-- > 0;) {
+			int cell = frontier[i];
+			if (depth[cell] == 0) {
+				if (!CanFlowInto(grid, cell)) RemoveFromFrontier(i);
+				continue;
+			}
+			int d = std::max(0, depth[cell] - amount);
+			volume -= depth[cell] - d;
+			depth[cell] = (uint8_t)d;
+			if (d > 0) wet++;
+			else dried++;
+		}
+		if (wet == 0 && dried == 0) dried = 1;
+		for (; dried > 0 && !filled.empty(); dried--) {
+			int cell = filled.back();
+			filled.pop_back();
+			inFrontier.Set(cell);
+			frontier.push_back(cell);
+		}
+	}
+};
@@ -0,0 +1,231 @@
+// Headless batch runner for Flood Escape. Plays full games with a bot instead of a
+// keyboard, no window needed, so it can run on CI for load tests and regression checks.
+//
+//   headless [games] [seed] [WxH] [backtracker|kruskal|wilson|prim|tiled] [wall|solver] [rivals]
+//
+// The wall bot follows the right-hand wall, the solver bot walks the shortest
+// route from the distance field. With rivals, that many AI rivals race alongside
+// the bot in every game and their totals are printed too. Prints win/loss counts, games per second, mazes
+// whose exit can't be reached from every cell, mazes thrown away as unwinnable
+// before play, and a checksum of all final states;
+// the checksum only changes when simulation behaviour changes.
+//
+//   headless ... --record FILE   also saves the last game as a replay
+//   headless --replay FILE       plays a replay (from the game or --record) as
+//                                fast as it goes and checks it against the
+//                                state hashes recorded with it
+//   headless ... --pack FILE     plays the levels of a maze pack (see mazepack.cpp)
+//                                in turn instead of generated mazes; WxH and the
+//                                generator are ignored
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include "sim.h"
+#include "endless.h"
+using namespace std;
+
+// Right-hand wall follower, steering from cell centre to cell centre.
+class WallFollowerBot {
+public:
+	int heading = 1; // 0 up, 1 right, 2 down, 3 left
+	int targetX = 0, targetY = 0;
+
+	void Reset() {
+		heading = 1;
+		targetX = 0;
+		targetY = 0;
+	}
+
+	uint8_t NextInput(const FloodGame& game) {
+		const Player2D& p = game.player;
+		const int cellSize = game.config.cellSize;
+		float cx = targetX * cellSize + cellSize / 2.0f;
+		float cy = targetY * cellSize + cellSize / 2.0f;
+
+		if (fabs(p.x - cx) < 0.5f && fabs(p.y - cy) < 0.5f) {
+			// At a cell centre: prefer right, then straight, left, back
+			static const int turns[4] = { 1, 0, 3, 2 };
+			static const int wallOf[4] = { WALL_TOP, WALL_RIGHT, WALL_BOTTOM, WALL_LEFT };
+			static const int dx[4] = { 0, 1, 0, -1 };
+			static const int dy[4] = { -1, 0, 1, 0 };
+			for (int t : turns) {
+				int dir = (heading + t) % 4;
+				if (!game.grid.HasWall(targetX, targetY, wallOf[dir])) {
+					heading = dir;
+					targetX += dx[dir];
+					targetY += dy[dir];
+					break;
+				}
+			}
+			cx = targetX * cellSize + cellSize / 2.0f;
+			cy = targetY * cellSize + cellSize / 2.0f;
+		}
+
+		uint8_t input = 0;
+		if (cy < p.y - 0.5f) input |= INPUT_UP;
+		if (cy > p.y + 0.5f) input |= INPUT_DOWN;
+		if (cx < p.x - 0.5f) input |= INPUT_LEFT;
+		if (cx > p.x + 0.5f) input |= INPUT_RIGHT;
+		return input;
+	}
+};
+
+static uint64_t Fnv1a(uint64_t h, const void* data, size_t len) {
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < len; i++) {
+		h ^= bytes[i];
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+// Steps a game just set up with NewGame(replay) through the replay's inputs;
+// true if every state hash matched
+template <class Game>
+bool Playback(Game& game, const Replay& replay, int& divergedAt) {
+	while (!game.IsOver() && game.ticks < replay.Ticks()) game.Step(replay.InputAt(game.ticks));
+
+	const vector<uint32_t>& now = game.replay.checkpoints;
+	const vector<uint32_t>& then = replay.checkpoints;
+	divergedAt = -1;
+	for (size_t i = 0; i < max(now.size(), then.size()) && divergedAt < 0; i++) {
+		if (i >= now.size() || i >= then.size() || now[i] != then[i]) divergedAt = (int)(i + 1) * TICK_RATE;
+	}
+	return divergedAt < 0 && game.ticks == replay.Ticks();
+}
+
+int PlayReplay(const string& path) {
+	Replay replay;
+	if (!replay.Load(path)) {
+		cerr << "can't read replay " << path << "\n";
+		return 1;
+	}
+	FloodGame game;
+	EndlessGame endless;
+	int divergedAt = -1, ticks = 0;
+	string result;
+	auto start = chrono::steady_clock::now();
+	bool same;
+	if (replay.mode == ReplayMode::Flood) {
+		if (!game.NewGame(replay)) {
+			if (game.pack.path != replay.packPath) cerr << "can't open maze pack " << replay.packPath << "\n";
+			else cerr << "maze pack " << replay.packPath << " has no level " << replay.packLevel << " or it is damaged\n";
+			return 1;
+		}
+		same = Playback(game, replay, divergedAt);
+		ticks = game.ticks;
+		result = game.hasWon ? "won" : game.waterSystem.IsGameOver() ? "drowned" : "stopped";
+	}
+	else {
+		endless.NewGame(replay);
+		same = Playback(endless, replay, divergedAt);
+		ticks = endless.ticks;
+		result = endless.IsOver() ? "drowned at height " + to_string(endless.RowsClimbed()) : "stopped";
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "replay:     " << (replay.mode == ReplayMode::Flood ? "flood " : "endless ")
+		<< replay.config.width << "x" << replay.config.height << " " << MazeAlgorithmName(replay.algorithm)
+		<< " seed " << hex << uppercase << setw(16) << setfill('0') << replay.seed << dec << setfill(' ') << "\n";
+	if (!replay.packPath.empty()) cout << "pack:       " << replay.packPath << " level " << replay.packLevel << "\n";
+	cout << "result:     " << result << " after " << ticks << " of " << replay.Ticks() << " ticks\n";
+	cout << "speed:      " << (seconds > 0 ? ticks / (double)TICK_RATE / seconds : 0) << "x real time\n";
+	if (same) cout << "matches:    all " << replay.checkpoints.size() << " state hashes\n";
+	else if (divergedAt >= 0) cout << "DIVERGED:   by tick " << divergedAt << "\n";
+	else cout << "DIVERGED:   game ended at tick " << ticks << "\n";
+	return same ? 0 : 2;
+}
+
+int main(int argc, char** argv) {
+	// --replay / --record / --pack first, then the positional arguments
+	string recordPath, packPath;
+	vector<char*> args;
+	for (int i = 0; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--replay" && i + 1 < argc) return PlayReplay(argv[i + 1]);
+		if (arg == "--record" && i + 1 < argc) recordPath = argv[++i];
+		else if (arg == "--pack" && i + 1 < argc) packPath = argv[++i];
+		else args.push_back(argv[i]);
+	}
+	argc = (int)args.size();
+	argv = args.data();
+
+	int games = argc > 1 ? atoi(argv[1]) : 1000;
+	uint64_t seed = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1;
+	const int maxTicks = TICK_RATE * 60 * 10; // give up after 10 minutes of game time
+
+	FloodGame game;
+	if (argc > 3) sscanf(argv[3], "%dx%d", &game.config.width, &game.config.height);
+	if (argc > 4 && !ParseMazeAlgorithm(argv[4], game.algorithm)) {
+		cerr << "unknown generator " << argv[4] << "\n";
+		return 1;
+	}
+	bool useSolver = argc > 5 && strcmp(argv[5], "solver") == 0;
+	if (argc > 6) game.rivalCount = max(0, atoi(argv[6]));
+	if (!packPath.empty() && (!game.OpenPack(packPath) || game.pack.Count() == 0)) {
+		cerr << "can't open maze pack " << packPath << "\n";
+		return 1;
+	}
+	WallFollowerBot bot;
+	SolverBot solverBot;
+	int wins = 0, drowned = 0, timeouts = 0, badMazes = 0;
+	long long totalTicks = 0;
+	long long rivalsEscaped = 0, rivalsDrowned = 0;
+	uint64_t checksum = 1469598103934665603ull;
+
+	auto start = chrono::steady_clock::now();
+	for (int g = 0; g < games; g++) {
+		if (game.pack.IsOpen()) {
+			if (!game.NewPackGame(g % game.pack.Count())) {
+				cerr << "maze pack level " << g % game.pack.Count() << " is damaged\n";
+				return 1;
+			}
+		}
+		else game.NewGame(seed + g);
+		bot.Reset();
+		solverBot.Reset(game.player);
+		if (!game.solver.Connected()) badMazes++;
+
+		while (!game.IsOver() && game.ticks < maxTicks) {
+			game.Step(useSolver ? solverBot.NextInput(game.player, game.solver) : bot.NextInput(game));
+		}
+
+		if (game.hasWon) wins++;
+		else if (game.waterSystem.IsGameOver()) drowned++;
+		else timeouts++;
+		totalTicks += game.ticks;
+
+		checksum = Fnv1a(checksum, &game.ticks, sizeof(game.ticks));
+		checksum = Fnv1a(checksum, &game.player.x, sizeof(float));
+		checksum = Fnv1a(checksum, &game.player.y, sizeof(float));
+		checksum = Fnv1a(checksum, &game.waterSystem.oxygenLevel, sizeof(float));
+		if (game.rivalCount > 0) {
+			rivalsEscaped += game.rivals.escaped;
+			rivalsDrowned += game.rivals.drowned;
+			checksum = Fnv1a(checksum, game.rivals.bodies.x.data(), game.rivalCount * sizeof(float));
+			checksum = Fnv1a(checksum, game.rivals.bodies.y.data(), game.rivalCount * sizeof(float));
+		}
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	if (!recordPath.empty() && !game.replay.Save(recordPath)) cerr << "can't write " << recordPath << "\n";
+
+	cout << "games:      " << games << "\n";
+	cout << "won:        " << wins << "\n";
+	cout << "drowned:    " << drowned << "\n";
+	cout << "timed out:  " << timeouts << "\n";
+	cout << "bad mazes:  " << badMazes << "\n";
+	cout << "rejected:   " << game.rejectedMazes << "\n";
+	if (game.rivalCount > 0) {
+		cout << "rivals out: " << rivalsEscaped << "\n";
+		cout << "rivals lost:" << rivalsDrowned << "\n";
+	}
+	cout << "avg ticks:  " << (games ? totalTicks / games : 0) << "\n";
+	cout << "games/sec:  " << (seconds > 0 ? games / seconds : 0) << "\n";
+	cout << "ticks/sec:  " << (seconds > 0 ? totalTicks / seconds : 0) << "\n";
+	cout << "checksum:   " << hex << checksum << dec << "\n";
+	return 0;
+}
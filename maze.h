@@ -0,0 +1,195 @@
+#pragma once
+// Maze grid storage; the generators live in mazegen.h. Kept free of raylib so
+// the simulation can run headless (see sim.h / headless.cpp).
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Maze size picked at runtime (menu or --size/--cell on the command line)
+struct MazeConfig {
+	int width = 20;
+	int height = 20;
+	int cellSize = 20;
+};
+
+enum WallSide { WALL_TOP = 0, WALL_BOTTOM = 1, WALL_LEFT = 2, WALL_RIGHT = 3 };
+
+// Dimensions of a maze. MazeExtent is read at runtime; FixedMazeExtent bakes them
+// in so index() and the wall lookups compile down to shifts and masks.
+struct MazeExtent {
+	int cols = 0;
+	int rows = 0;
+	int wordsPerRow = 0;
+
+	MazeExtent() {}
+	MazeExtent(int c, int r) : cols(c), rows(r), wordsPerRow((c * 2 + 63) / 64) {}
+};
+
+template <int COLS, int ROWS>
+struct FixedMazeExtent {
+	static constexpr int cols = COLS;
+	static constexpr int rows = ROWS;
+	static constexpr int wordsPerRow = (COLS * 2 + 63) / 64;
+};
+
+// Bit-packed maze walls. Each cell only owns its right and bottom wall (2 bits),
+// the top/left walls are read from the neighbour above/left. The top/left border
+// is implicit and the right/bottom border bits are simply never cleared.
+// Rows start on a fresh 64-bit word so a row can be touched without sharing
+// words with the rows around it.
+// 4096x4096 is 4 MB here versus 80 MB as vector<Cell>.
+//
+// MazeView doesn't own the words; MazeGrid below does.
+template <class Extent>
+class MazeView : public Extent {
+public:
+	uint64_t* words = nullptr;
+
+	MazeView() {}
+	MazeView(const Extent& extent, uint64_t* w) : Extent(extent), words(w) {}
+
+	int CellCount() const { return this->cols * this->rows; }
+	int FirstRow() const { return 0; }
+	int EndRow() const { return this->rows; }
+
+	int index(int x, int y) const {
+		if (x < 0 || x >= this->cols || y < 0 || y >= this->rows) {
+			return -1;
+		}
+		return x + y * this->cols;
+	}
+
+	// Both owned walls of a cell: bit 0 right, bit 1 bottom
+	int WallBits(int x, int y) const {
+		return (Word(x, y) >> ((x & 31) * 2)) & 3;
+	}
+
+	bool RightWall(int x, int y) const {
+		return (Word(x, y) >> ((x & 31) * 2)) & 1;
+	}
+
+	bool BottomWall(int x, int y) const {
+		return (Word(x, y) >> ((x & 31) * 2 + 1)) & 1;
+	}
+
+	bool HasWall(int x, int y, int side) const {
+		switch (side) {
+		case WALL_TOP: return y == 0 || BottomWall(x, y - 1);
+		case WALL_BOTTOM: return BottomWall(x, y);
+		case WALL_LEFT: return x == 0 || RightWall(x - 1, y);
+		default: return RightWall(x, y);
+		}
+	}
+
+	// Opens the wall on one side of a cell; the neighbour sees the same bit.
+	// Border walls can't be removed.
+	void RemoveWall(int x, int y, int side) {
+		switch (side) {
+		case WALL_TOP: if (y > 0) ClearBit(x, y - 1, 1); break;
+		case WALL_BOTTOM: if (y < this->rows - 1) ClearBit(x, y, 1); break;
+		case WALL_LEFT: if (x > 0) ClearBit(x - 1, y, 0); break;
+		default: if (x < this->cols - 1) ClearBit(x, y, 0); break;
+		}
+	}
+
+	// Put every wall back (what maze generation starts from)
+	void FillWalls() {
+		std::fill(words, words + (size_t)this->wordsPerRow * this->rows, ~0ull);
+	}
+
+private:
+	uint64_t Word(int x, int y) const {
+		return words[(size_t)y * this->wordsPerRow + (x >> 5)];
+	}
+
+	void ClearBit(int x, int y, int bit) {
+		words[(size_t)y * this->wordsPerRow + (x >> 5)] &= ~(1ull << ((x & 31) * 2 + bit));
+	}
+};
+
+class MazeGrid : public MazeView<MazeExtent> {
+public:
+	std::vector<uint64_t> storage;
+
+	MazeGrid() {}
+	MazeGrid(int c, int r) { Resize(c, r); }
+	MazeGrid(const MazeGrid& other) : MazeView(other), storage(other.storage) {
+		words = other.Borrowed() ? other.words : storage.data();
+	}
+
+	MazeGrid& operator=(const MazeGrid& other) {
+		MazeView::operator=(other);
+		storage = other.storage;
+		words = other.Borrowed() ? other.words : storage.data();
+		return *this;
+	}
+
+	// Moving keeps the walls where they are, so it's cheap enough to swap grids
+	MazeGrid(MazeGrid&& other) noexcept : MazeView(other) {
+		bool borrowed = other.Borrowed();
+		storage = std::move(other.storage);
+		words = borrowed ? other.words : storage.data();
+	}
+
+	MazeGrid& operator=(MazeGrid&& other) noexcept {
+		bool borrowed = other.Borrowed();
+		MazeView::operator=(other);
+		storage = std::move(other.storage);
+		words = borrowed ? other.words : storage.data();
+		return *this;
+	}
+
+	void Resize(int c, int r) {
+		static_cast<MazeExtent&>(*this) = MazeExtent(c, r);
+		storage.assign((size_t)wordsPerRow * rows, ~0ull);
+		words = storage.data();
+	}
+
+	// Uses walls someone else owns (a level in a mapped maze pack) in place.
+	// They must outlive the grid, or the next Resize()/assignment.
+	void Borrow(int c, int r, uint64_t* w) {
+		static_cast<MazeExtent&>(*this) = MazeExtent(c, r);
+		storage.clear();
+		words = w;
+	}
+
+	bool Borrowed() const { return storage.empty() && words != nullptr; }
+
+	// Copies borrowed walls into the grid's own storage, so what they were
+	// borrowed from can go away
+	void Own() {
+		if (!Borrowed()) return;
+		storage.assign(words, words + (size_t)wordsPerRow * rows);
+		words = storage.data();
+	}
+
+	size_t MemoryBytes() const {
+		return storage.size() * sizeof(uint64_t);
+	}
+};
+
+// Calls f with a view of the grid whose dimensions are compile-time constants
+// when the grid is one of the common sizes, and a runtime view otherwise.
+template <class F>
+void WithMazeView(const MazeGrid& grid, F&& f) {
+	if (grid.cols == grid.rows) {
+		switch (grid.cols) {
+		case 20: f(MazeView<FixedMazeExtent<20, 20>>({}, grid.words)); return;
+		case 32: f(MazeView<FixedMazeExtent<32, 32>>({}, grid.words)); return;
+		case 64: f(MazeView<FixedMazeExtent<64, 64>>({}, grid.words)); return;
+		case 128: f(MazeView<FixedMazeExtent<128, 128>>({}, grid.words)); return;
+		}
+	}
+	f(static_cast<const MazeView<MazeExtent>&>(grid));
+}
+
+// Visited flags for generators and searches. Lives only as long as the pass that needs it.
+class BitSet {
+public:
+	std::vector<uint64_t> bits;
+
+	void Resize(size_t n) { bits.assign((n + 63) / 64, 0); }
+	bool Test(size_t i) const { return (bits[i >> 6] >> (i & 63)) & 1; }
+	void Set(size_t i) { bits[i >> 6] |= 1ull << (i & 63); }
+	void Clear(size_t i) { bits[i >> 6] &= ~(1ull << (i & 63)); }
+};
@@ -0,0 +1,389 @@
+#pragma once
+// Maze generation algorithms behind one interface, picked at runtime.
+// Every generator keeps its scratch buffers between calls, so regenerating a
+// maze of the same size doesn't allocate.
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include "maze.h"
+#include "rng.h"
+#include "parallel.h"
+
+enum class MazeAlgorithm { Backtracker, Kruskal, Wilson, Prim, Tiled, Count };
+
+inline const char* MazeAlgorithmName(MazeAlgorithm algorithm) {
+	switch (algorithm) {
+	case MazeAlgorithm::Backtracker: return "backtracker";
+	case MazeAlgorithm::Kruskal: return "kruskal";
+	case MazeAlgorithm::Wilson: return "wilson";
+	case MazeAlgorithm::Prim: return "prim";
+	case MazeAlgorithm::Tiled: return "tiled";
+	default: return "?";
+	}
+}
+
+inline bool ParseMazeAlgorithm(const char* name, MazeAlgorithm& out) {
+	for (int i = 0; i < (int)MazeAlgorithm::Count; i++) {
+		if (strcmp(name, MazeAlgorithmName((MazeAlgorithm)i)) == 0) {
+			out = (MazeAlgorithm)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+class MazeGenerator {
+public:
+	virtual ~MazeGenerator() {}
+	virtual MazeAlgorithm Algorithm() const = 0;
+	// Carves a perfect maze into grid (all walls are reset first)
+	virtual void Generate(MazeGrid& grid, Rng& rng) = 0;
+};
+
+// Offsets per WallSide (top, bottom, left, right)
+static const int sideDX[4] = { 0, 0, -1, 1 };
+static const int sideDY[4] = { -1, 1, 0, 0 };
+
+// Depth-first recursive backtracker (the original maze_generation), long winding corridors.
+class BacktrackerGenerator : public MazeGenerator {
+public:
+	std::vector<int> stack;
+	BitSet visited;
+
+	MazeAlgorithm Algorithm() const override { return MazeAlgorithm::Backtracker; }
+
+	void Generate(MazeGrid& grid, Rng& rng) override {
+		WithMazeView(grid, [&](auto view) { Run(view, rng); });
+	}
+
+	template <class Grid>
+	void Run(Grid grid, Rng& rng) {
+		grid.FillWalls();
+		visited.Resize(grid.CellCount());
+		stack.clear();
+
+		int x = 0, y = 0;
+		visited.Set(grid.index(x, y));
+		stack.push_back(grid.index(x, y));
+
+		while (!stack.empty()) {
+			int options[4];
+			int count = 0;
+			for (int side = 0; side < 4; side++) {
+				int n = grid.index(x + sideDX[side], y + sideDY[side]);
+				if (n != -1 && !visited.Test(n)) options[count++] = side;
+			}
+
+			if (count > 0) {
+				int side = options[rng.Below(count)];
+				grid.RemoveWall(x, y, side);
+				x += sideDX[side];
+				y += sideDY[side];
+				int cell = grid.index(x, y);
+				visited.Set(cell);
+				stack.push_back(cell);
+			}
+			else {
+				stack.pop_back();
+				if (!stack.empty()) {
+					x = stack.back() % grid.cols;
+					y = stack.back() / grid.cols;
+				}
+			}
+		}
+	}
+};
+
+// Randomised Kruskal: shuffle every interior wall, knock it down if it joins two
+// separate regions (union-find). Short dead ends, lots of branching.
+class KruskalGenerator : public MazeGenerator {
+public:
+	std::vector<uint32_t> edges;  // cell * 2 + (0 right wall, 1 bottom wall)
+	std::vector<uint32_t> parent;
+	std::vector<uint8_t> rank;
+
+	MazeAlgorithm Algorithm() const override { return MazeAlgorithm::Kruskal; }
+
+	void Generate(MazeGrid& grid, Rng& rng) override {
+		WithMazeView(grid, [&](auto view) { Run(view, rng); });
+	}
+
+	uint32_t Find(uint32_t a) {
+		while (parent[a] != a) {
+			parent[a] = parent[parent[a]]; // path halving
+			a = parent[a];
+		}
+		return a;
+	}
+
+	template <class Grid>
+	void Run(Grid grid, Rng& rng) {
+		grid.FillWalls();
+		const int cells = grid.CellCount();
+
+		edges.clear();
+		for (int y = 0; y < grid.rows; y++) {
+			for (int x = 0; x < grid.cols; x++) {
+				uint32_t cell = grid.index(x, y);
+				if (x < grid.cols - 1) edges.push_back(cell * 2);
+				if (y < grid.rows - 1) edges.push_back(cell * 2 + 1);
+			}
+		}
+		for (size_t i = edges.size(); i > 1; i--) {
+			std::swap(edges[i - 1], edges[rng.Below((uint32_t)i)]);
+		}
+
+		parent.resize(cells);
+		for (int i = 0; i < cells; i++) parent[i] = i;
+		rank.assign(cells, 0);
+
+		int joined = 0;
+		for (uint32_t edge : edges) {
+			uint32_t a = edge >> 1;
+			uint32_t b = (edge & 1) ? a + grid.cols : a + 1;
+			uint32_t ra = Find(a), rb = Find(b);
+			if (ra == rb) continue;
+			if (rank[ra] < rank[rb]) std::swap(ra, rb);
+			parent[rb] = ra;
+			if (rank[ra] == rank[rb]) rank[ra]++;
+			grid.RemoveWall(a % grid.cols, a / grid.cols, (edge & 1) ? WALL_BOTTOM : WALL_RIGHT);
+			if (++joined == cells - 1) break;
+		}
+	}
+};
+
+// Wilson's loop-erased random walks: uniform spanning tree, no directional bias.
+// Slow to get going on big grids (the first walk has to find a single cell).
+class WilsonGenerator : public MazeGenerator {
+public:
+	BitSet inMaze;
+	std::vector<uint8_t> walkSide; // last side each cell was left by during the current walk
+
+	MazeAlgorithm Algorithm() const override { return MazeAlgorithm::Wilson; }
+
+	void Generate(MazeGrid& grid, Rng& rng) override {
+		WithMazeView(grid, [&](auto view) { Run(view, rng); });
+	}
+
+	template <class Grid>
+	void Run(Grid grid, Rng& rng) {
+		grid.FillWalls();
+		const int cells = grid.CellCount();
+		inMaze.Resize(cells);
+		walkSide.resize(cells);
+
+		inMaze.Set(rng.Below(cells));
+
+		for (int start = 0; start < cells; start++) {
+			if (inMaze.Test(start)) continue;
+
+			// Random walk until the maze is hit; revisiting a cell overwrites its
+			// exit side, which erases the loop.
+			int x = start % grid.cols, y = start / grid.cols;
+			int cell = start;
+			while (!inMaze.Test(cell)) {
+				int side;
+				int nx, ny;
+				do {
+					side = rng.Below(4);
+					nx = x + sideDX[side];
+					ny = y + sideDY[side];
+				} while (nx < 0 || ny < 0 || nx >= grid.cols || ny >= grid.rows);
+				walkSide[cell] = (uint8_t)side;
+				x = nx;
+				y = ny;
+				cell = grid.index(x, y);
+			}
+
+			// Carve the loop-erased path
+			x = start % grid.cols;
+			y = start / grid.cols;
+			cell = start;
+			while (!inMaze.Test(cell)) {
+				inMaze.Set(cell);
+				int side = walkSide[cell];
+				grid.RemoveWall(x, y, side);
+				x += sideDX[side];
+				y += sideDY[side];
+				cell = grid.index(x, y);
+			}
+		}
+	}
+};
+
+// Randomised Prim: grow from one cell, attaching a random frontier cell each step.
+// Very short, bushy dead ends radiating from the start.
+class PrimGenerator : public MazeGenerator {
+public:
+	enum : uint8_t { OUT = 0, FRONTIER = 1, IN = 2 };
+	std::vector<uint8_t> state;
+	std::vector<int> frontier;
+
+	MazeAlgorithm Algorithm() const override { return MazeAlgorithm::Prim; }
+
+	void Generate(MazeGrid& grid, Rng& rng) override {
+		WithMazeView(grid, [&](auto view) { Run(view, rng); });
+	}
+
+	template <class Grid>
+	void AddCell(Grid& grid, int x, int y) {
+		state[grid.index(x, y)] = IN;
+		for (int side = 0; side < 4; side++) {
+			int n = grid.index(x + sideDX[side], y + sideDY[side]);
+			if (n != -1 && state[n] == OUT) {
+				state[n] = FRONTIER;
+				frontier.push_back(n);
+			}
+		}
+	}
+
+	template <class Grid>
+	void Run(Grid grid, Rng& rng) {
+		grid.FillWalls();
+		const int cells = grid.CellCount();
+		state.assign(cells, OUT);
+		frontier.clear();
+
+		int start = rng.Below(cells);
+		AddCell(grid, start % grid.cols, start / grid.cols);
+
+		while (!frontier.empty()) {
+			size_t pick = rng.Below((uint32_t)frontier.size());
+			int cell = frontier[pick];
+			frontier[pick] = frontier.back();
+			frontier.pop_back();
+
+			int x = cell % grid.cols, y = cell / grid.cols;
+			int options[4];
+			int count = 0;
+			for (int side = 0; side < 4; side++) {
+				int n = grid.index(x + sideDX[side], y + sideDY[side]);
+				if (n != -1 && state[n] == IN) options[count++] = side;
+			}
+			grid.RemoveWall(x, y, options[rng.Below(count)]);
+			AddCell(grid, x, y);
+		}
+	}
+};
+
+// A rectangle of a bigger grid that looks like a whole grid to the generators.
+// Walls on the tile's outer edge are left alone (RemoveWall checks the tile bounds
+// through index()/rows/cols exactly like the real border).
+template <class Grid>
+class MazeTileView {
+public:
+	Grid grid;
+	int x0, y0;
+	int cols, rows;
+
+	MazeTileView(Grid g, int x, int y, int c, int r) : grid(g), x0(x), y0(y), cols(c), rows(r) {}
+
+	int CellCount() const { return cols * rows; }
+	void FillWalls() {} // the whole grid is filled once before the tiles run
+
+	int index(int x, int y) const {
+		if (x < 0 || x >= cols || y < 0 || y >= rows) {
+			return -1;
+		}
+		return x + y * cols;
+	}
+
+	void RemoveWall(int x, int y, int side) {
+		if (side == WALL_TOP && y == 0) return;
+		if (side == WALL_BOTTOM && y == rows - 1) return;
+		if (side == WALL_LEFT && x == 0) return;
+		if (side == WALL_RIGHT && x == cols - 1) return;
+		grid.RemoveWall(x0 + x, y0 + y, side);
+	}
+};
+
+// Splits the grid into TILE x TILE tiles, runs the backtracker on each tile on a
+// worker thread, then joins the tiles with a random spanning tree over the tile
+// grid, one opening per joined seam, so the result is still a perfect maze.
+// TILE is a multiple of 32 cells, so tiles never share a 64-bit word of the grid
+// and can write to it directly. Each tile draws from its own RNG stream
+// (RNG_TILE + tile under the maze seed), never from the thread, so the maze is the
+// same for any thread count.
+class TiledGenerator : public MazeGenerator {
+public:
+	static constexpr int TILE = 128;
+	int threads = DefaultThreadCount();
+	std::vector<BacktrackerGenerator> workers;
+	std::vector<uint32_t> seams;   // tile * 2 + (0 right seam, 1 bottom seam)
+	std::vector<uint32_t> parent;
+
+	MazeAlgorithm Algorithm() const override { return MazeAlgorithm::Tiled; }
+
+	void Generate(MazeGrid& grid, Rng& rng) override {
+		WithMazeView(grid, [&](auto view) { Run(view, rng); });
+	}
+
+	uint32_t Find(uint32_t a) {
+		while (parent[a] != a) {
+			parent[a] = parent[parent[a]];
+			a = parent[a];
+		}
+		return a;
+	}
+
+	template <class Grid>
+	void Run(Grid grid, Rng& rng) {
+		grid.FillWalls();
+		const uint64_t seed = rng.Next();
+		const int tilesX = (grid.cols + TILE - 1) / TILE;
+		const int tilesY = (grid.rows + TILE - 1) / TILE;
+		const int tiles = tilesX * tilesY;
+
+		if ((int)workers.size() < threads) workers.resize(threads);
+		ParallelFor(tiles, threads, [&](int tile, int worker) {
+			int tx = tile % tilesX, ty = tile / tilesX;
+			int x0 = tx * TILE, y0 = ty * TILE;
+			MazeTileView<Grid> view(grid, x0, y0,
+				std::min(TILE, grid.cols - x0), std::min(TILE, grid.rows - y0));
+			Rng tileRng(seed, RNG_TILE + tile);
+			workers[worker].Run(view, tileRng);
+		});
+
+		// Stitch: Kruskal over the tile grid, one random opening per seam used
+		seams.clear();
+		for (int t = 0; t < tiles; t++) {
+			if (t % tilesX < tilesX - 1) seams.push_back(t * 2);
+			if (t / tilesX < tilesY - 1) seams.push_back(t * 2 + 1);
+		}
+		Rng stitchRng(seed, RNG_STITCH);
+		for (size_t i = seams.size(); i > 1; i--) {
+			std::swap(seams[i - 1], seams[stitchRng.Below((uint32_t)i)]);
+		}
+		parent.resize(tiles);
+		for (int t = 0; t < tiles; t++) parent[t] = t;
+
+		for (uint32_t seam : seams) {
+			uint32_t a = seam >> 1;
+			uint32_t b = (seam & 1) ? a + tilesX : a + 1;
+			uint32_t ra = Find(a), rb = Find(b);
+			if (ra == rb) continue;
+			parent[rb] = ra;
+
+			int x0 = (a % tilesX) * TILE, y0 = (a / tilesX) * TILE;
+			if (seam & 1) {
+				int span = std::min(TILE, grid.cols - x0);
+				grid.RemoveWall(x0 + stitchRng.Below(span), y0 + TILE - 1, WALL_BOTTOM);
+			}
+			else {
+				int span = std::min(TILE, grid.rows - y0);
+				grid.RemoveWall(x0 + TILE - 1, y0 + stitchRng.Below(span), WALL_RIGHT);
+			}
+		}
+	}
+};
+
+inline std::unique_ptr<MazeGenerator> MakeMazeGenerator(MazeAlgorithm algorithm) {
+	switch (algorithm) {
+	case MazeAlgorithm::Kruskal: return std::unique_ptr<MazeGenerator>(new KruskalGenerator());
+	case MazeAlgorithm::Wilson: return std::unique_ptr<MazeGenerator>(new WilsonGenerator());
+	case MazeAlgorithm::Prim: return std::unique_ptr<MazeGenerator>(new PrimGenerator());
+	case MazeAlgorithm::Tiled: return std::unique_ptr<MazeGenerator>(new TiledGenerator());
+	default: return std::unique_ptr<MazeGenerator>(new BacktrackerGenerator());
+	}
+}
@@ -0,0 +1,194 @@
+// Maze pack tool for Flood Escape: builds the packs the game and headless load
+// with --pack, and takes them apart again. No window needed.
+//
+//   mazepack export OUT COUNT [WxH] [generator] [seed]
+//       COUNT winnable mazes from the generator, picked the same way the game
+//       picks them, with their bubbles and drains
+//   mazepack import OUT FILE...
+//       one hand drawn level per text file, drawn the way `ascii` prints them
+//   mazepack list FILE
+//   mazepack ascii FILE LEVEL
+//
+// A level in ASCII, B an air bubble, D a drain switch, in the middle of a cell:
+//
+//   +--+--+--+
+//   |B    |  |
+//   +--+  +  +
+//   |     D  |
+//   +--+--+--+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "maze.h"
+#include "mazegen.h"
+#include "mazepack.h"
+#include "sim.h"
+using namespace std;
+
+static int Usage() {
+	cerr << "usage: mazepack export OUT COUNT [WxH] [generator] [seed]\n"
+		<< "       mazepack import OUT FILE...\n"
+		<< "       mazepack list FILE\n"
+		<< "       mazepack ascii FILE LEVEL\n";
+	return 1;
+}
+
+static int Export(int argc, char** argv) {
+	if (argc < 4) return Usage();
+	const string out = argv[2];
+	const int count = atoi(argv[3]);
+	FloodGame game;
+	if (argc > 4) sscanf(argv[4], "%dx%d", &game.config.width, &game.config.height);
+	if (argc > 5 && !ParseMazeAlgorithm(argv[5], game.algorithm)) {
+		cerr << "unknown generator " << argv[5] << "\n";
+		return 1;
+	}
+	uint64_t seed = argc > 6 ? strtoull(argv[6], nullptr, 10) : 1;
+
+	MazePackWriter writer;
+	const float cellSize = (float)game.config.cellSize;
+	for (int i = 0; i < count; i++) {
+		game.NewGame(seed + i);
+		vector<float> bubbles, drains;
+		for (auto& bubble : game.waterSystem.airBubbles) {
+			bubbles.push_back(bubble.x / cellSize);
+			bubbles.push_back(bubble.y / cellSize);
+		}
+		for (auto& drain : game.waterSystem.drainSwitches) {
+			drains.push_back(drain.x / cellSize);
+			drains.push_back(drain.y / cellSize);
+		}
+		writer.Add(game.grid, game.config.cellSize, game.algorithm, game.seed, "seed " + to_string(seed + i), bubbles, drains);
+	}
+	if (!writer.Save(out)) {
+		cerr << "can't write " << out << "\n";
+		return 1;
+	}
+	cout << "wrote " << count << " levels to " << out << "\n";
+	return 0;
+}
+
+// Reads one level drawn as ASCII art; false if the drawing doesn't line up
+static bool ReadAscii(const string& file, MazeGrid& grid, vector<float>& bubbles, vector<float>& drains) {
+	ifstream in(file);
+	vector<string> lines;
+	for (string line; getline(in, line);) {
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (!line.empty()) lines.push_back(line);
+	}
+	if (lines.size() < 3 || lines[0].size() < 4) return false;
+	const int width = (int)(lines[0].size() - 1) / 3;
+	const int height = (int)(lines.size() - 1) / 2;
+	grid.Resize(width, height);
+
+	for (int y = 0; y < height; y++) {
+		const string& row = lines[y * 2 + 1];
+		const string& below = lines[y * 2 + 2];
+		for (int x = 0; x < width; x++) {
+			auto at = [](const string& s, size_t i) { return i < s.size() ? s[i] : ' '; };
+			if (at(row, x * 3 + 3) != '|') grid.RemoveWall(x, y, WALL_RIGHT);
+			if (at(below, x * 3 + 1) != '-') grid.RemoveWall(x, y, WALL_BOTTOM);
+			for (int c = 1; c <= 2; c++) {
+				char mark = at(row, x * 3 + c);
+				if (mark == 'B' || mark == 'b') { bubbles.push_back(x + 0.5f); bubbles.push_back(y + 0.5f); }
+				if (mark == 'D' || mark == 'd') { drains.push_back(x + 0.5f); drains.push_back(y + 0.5f); }
+			}
+		}
+	}
+	return true;
+}
+
+static int Import(int argc, char** argv) {
+	if (argc < 4) return Usage();
+	MazePackWriter writer;
+	MazeGrid grid;
+	for (int i = 3; i < argc; i++) {
+		vector<float> bubbles, drains;
+		if (!ReadAscii(argv[i], grid, bubbles, drains)) {
+			cerr << "can't read a maze from " << argv[i] << "\n";
+			return 1;
+		}
+		// Name it after the file, without the directory and extension
+		string name = argv[i];
+		name = name.substr(name.find_last_of("/\\") + 1);
+		name = name.substr(0, name.find('.'));
+		writer.Add(grid, MazeConfig().cellSize, MazeAlgorithm::Count, 0, name, bubbles, drains);
+	}
+	if (!writer.Save(argv[2])) {
+		cerr << "can't write " << argv[2] << "\n";
+		return 1;
+	}
+	cout << "wrote " << argc - 3 << " levels to " << argv[2] << "\n";
+	return 0;
+}
+
+static int List(const char* file) {
+	auto start = chrono::steady_clock::now();
+	MazePack pack;
+	if (!pack.Open(file)) {
+		cerr << "can't open maze pack " << file << "\n";
+		return 1;
+	}
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	cout << pack.Count() << " levels, opened in " << ms << " ms\n";
+	for (int i = 0; i < pack.Count(); i++) {
+		const MazePackLevel& level = pack.Level(i);
+		const char* made = level.algorithm < (uint32_t)MazeAlgorithm::Count
+			? MazeAlgorithmName((MazeAlgorithm)level.algorithm) : "hand made";
+		cout << i << ": " << pack.Name(i) << "  " << level.width << "x" << level.height << " " << made
+			<< ", " << level.bubbleCount << " bubbles, " << level.drainCount << " drains"
+			<< (pack.LevelValid(i) ? "" : "  DAMAGED") << "\n";
+	}
+	return 0;
+}
+
+static int Ascii(const char* file, int index) {
+	MazePack pack;
+	if (!pack.Open(file) || !pack.LevelValid(index)) {
+		cerr << "no level " << index << " in " << file << "\n";
+		return 1;
+	}
+	const MazePackLevel& level = pack.Level(index);
+	MazeView<MazeExtent> view(MazeExtent(level.width, level.height), pack.Walls(index));
+
+	// Markers go in the cell a spot is in
+	vector<char> marks((size_t)view.cols * view.rows, ' ');
+	auto mark = [&](const float* spots, uint32_t count, char c) {
+		for (uint32_t i = 0; i < count; i++) {
+			int x = (int)spots[i * 2], y = (int)spots[i * 2 + 1];
+			if (view.index(x, y) >= 0) marks[view.index(x, y)] = c;
+		}
+	};
+	mark(pack.Bubbles(index), level.bubbleCount, 'B');
+	mark(pack.Drains(index), level.drainCount, 'D');
+
+	string line = "+";
+	for (int x = 0; x < view.cols; x++) line += "--+";
+	cout << line << "\n";
+	for (int y = 0; y < view.rows; y++) {
+		string row = "|", below = "+";
+		for (int x = 0; x < view.cols; x++) {
+			row += marks[view.index(x, y)];
+			row += ' ';
+			row += view.HasWall(x, y, WALL_RIGHT) ? '|' : ' ';
+			below += view.HasWall(x, y, WALL_BOTTOM) ? "--+" : "  +";
+		}
+		cout << row << "\n" << below << "\n";
+	}
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3) return Usage();
+	string command = argv[1];
+	if (command == "export") return Export(argc, argv);
+	if (command == "import") return Import(argc, argv);
+	if (command == "list") return List(argv[2]);
+	if (command == "ascii" && argc > 3) return Ascii(argv[2], atoi(argv[3]));
+	return Usage();
+}
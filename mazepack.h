@@ -0,0 +1,243 @@
+#pragma once
+// Maze packs: many levels in one file, walls stored exactly as MazeView keeps
+// them in memory, so a level is used straight from the mapped file without
+// parsing or copying. Opening a pack only reads the header; a pack of thousands
+// of levels, or of a few huge ones, opens in the same time. No raylib in here.
+//
+// File layout, little-endian, every section 8-byte aligned:
+//   MazePackHeader
+//   MazePackLevel[levelCount]               the directory
+//   per level: walls, wordsPerRow * height uint64 (MazeView layout)
+//              spots, (bubbleCount + drainCount) * 2 float, x y in cells
+//
+// mazepack.cpp builds packs (from seeds or ASCII art) and takes them apart again.
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include "maze.h"
+#include "mazegen.h"
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+struct MazePackHeader {
+	char magic[8];            // "FEMAZEPK"
+	uint32_t version;
+	uint32_t levelCount;
+	uint64_t directoryOffset;
+	uint64_t fileSize;        // catches truncated files
+	uint8_t reserved[32];
+};
+
+struct MazePackLevel {
+	uint32_t width, height;
+	uint32_t cellSize;        // what it was made for; the game may draw it at another size
+	uint32_t algorithm;       // MazeAlgorithm it was generated with, Count if hand made
+	uint64_t seed;            // seed it was generated from, 0 if hand made
+	uint64_t wallsOffset;
+	uint64_t spotsOffset;
+	uint32_t bubbleCount;
+	uint32_t drainCount;
+	char name[16];            // zero padded, not always terminated
+};
+
+static_assert(sizeof(MazePackHeader) == 64, "pack header layout");
+static_assert(sizeof(MazePackLevel) == 64, "pack level layout");
+
+// An open pack, read-only as far as the file is concerned. Mapped private and
+// writable, so a grid borrowing a level's walls could even change them without
+// touching the file. Where mmap isn't available the file is read in whole.
+class MazePack {
+public:
+	static const uint32_t VERSION = 1;
+	// Cells a level may have: the game sizes its per-cell buffers with int
+	// cols * rows (plus one here and there), so stay well clear of INT_MAX
+	static constexpr uint64_t MAX_CELLS = 1ull << 28;
+
+	std::string path;
+
+	MazePack() {}
+	MazePack(const MazePack&) = delete;
+	MazePack& operator=(const MazePack&) = delete;
+	~MazePack() { Close(); }
+
+	bool Open(const std::string& file) {
+		Close();
+		const uint16_t probe = 1;
+		if (*(const uint8_t*)&probe != 1) return false; // walls are stored little-endian
+#if !defined(_WIN32)
+		int fd = open(file.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(MazePackHeader)) {
+			void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED) {
+				base = (uint8_t*)p;
+				size = (size_t)st.st_size;
+				mapped = true;
+			}
+		}
+		close(fd);
+#else
+		FILE* f = fopen(file.c_str(), "rb");
+		if (!f) return false;
+		std::vector<uint8_t> bytes;
+		uint8_t chunk[65536];
+		for (size_t n; (n = fread(chunk, 1, sizeof(chunk), f)) > 0;) bytes.insert(bytes.end(), chunk, chunk + n);
+		fclose(f);
+		copy.resize((bytes.size() + 7) / 8);
+		if (!bytes.empty()) memcpy(copy.data(), bytes.data(), bytes.size());
+		base = (uint8_t*)copy.data();
+		size = bytes.size();
+#endif
+		if (!base || !CheckHeader()) {
+			Close();
+			return false;
+		}
+		path = file;
+		return true;
+	}
+
+	void Close() {
+#if !defined(_WIN32)
+		if (mapped) munmap(base, size);
+#endif
+		mapped = false;
+		copy.clear();
+		base = nullptr;
+		size = 0;
+		path.clear();
+	}
+
+	bool IsOpen() const { return base != nullptr; }
+	int Count() const { return IsOpen() ? (int)Header().levelCount : 0; }
+
+	const MazePackLevel& Level(int i) const {
+		return ((const MazePackLevel*)(base + Header().directoryOffset))[i];
+	}
+
+	// Checks one level's sections lie inside the file, its right and bottom
+	// border walls are all there (the solver and the flood walk the grid without
+	// bounds checks, trusting them) and its spots are inside the maze. Done when
+	// a level is used rather than at Open(), so opening stays constant time.
+	bool LevelValid(int i) const {
+		if (i < 0 || i >= Count()) return false;
+		const MazePackLevel& level = Level(i);
+		if (level.width == 0 || level.height == 0 || level.width > 65536 || level.height > 65536) return false;
+		if ((uint64_t)level.width * level.height > MAX_CELLS) return false;
+		uint64_t wallBytes = (uint64_t)MazeExtent(level.width, level.height).wordsPerRow * level.height * 8;
+		uint64_t spotBytes = ((uint64_t)level.bubbleCount + level.drainCount) * 8;
+		bool inFile = level.wallsOffset % 8 == 0 && level.spotsOffset % 4 == 0
+			&& level.wallsOffset <= size && wallBytes <= size - level.wallsOffset
+			&& level.spotsOffset <= size && spotBytes <= size - level.spotsOffset;
+		if (!inFile) return false;
+
+		MazeView<MazeExtent> view(MazeExtent(level.width, level.height), Walls(i));
+		for (int y = 0; y < view.rows; y++) {
+			if (!view.RightWall(view.cols - 1, y)) return false;
+		}
+		for (int x = 0; x < view.cols; x++) {
+			if (!view.BottomWall(x, view.rows - 1)) return false;
+		}
+		const float* spots = Bubbles(i);
+		for (uint64_t s = 0; s < (uint64_t)level.bubbleCount + level.drainCount; s++) {
+			float x = spots[s * 2], y = spots[s * 2 + 1];
+			// Written this way round so NaN fails too
+			if (!(x >= 0 && x < level.width && y >= 0 && y < level.height)) return false;
+		}
+		return true;
+	}
+
+	// The level's walls in place, no copy
+	uint64_t* Walls(int i) const { return (uint64_t*)(base + Level(i).wallsOffset); }
+
+	// x, y pairs in cells: bubbles first, then drains
+	const float* Bubbles(int i) const { return (const float*)(base + Level(i).spotsOffset); }
+	const float* Drains(int i) const { return Bubbles(i) + Level(i).bubbleCount * 2; }
+
+	std::string Name(int i) const {
+		const char* name = Level(i).name;
+		return std::string(name, strnlen(name, sizeof(Level(i).name)));
+	}
+
+private:
+	uint8_t* base = nullptr;
+	size_t size = 0;
+	bool mapped = false;
+	std::vector<uint64_t> copy;  // the whole file when it couldn't be mapped
+
+	const MazePackHeader& Header() const { return *(const MazePackHeader*)base; }
+
+	bool CheckHeader() const {
+		if (size < sizeof(MazePackHeader)) return false;
+		const MazePackHeader& h = Header();
+		if (memcmp(h.magic, "FEMAZEPK", 8) != 0 || h.version != VERSION || h.fileSize != size) return false;
+		return h.directoryOffset % 8 == 0 && h.directoryOffset <= size
+			&& (uint64_t)h.levelCount * sizeof(MazePackLevel) <= size - h.directoryOffset;
+	}
+};
+
+// Collects levels and writes them out as a pack
+class MazePackWriter {
+public:
+	struct Entry {
+		MazePackLevel level;
+		std::vector<uint64_t> walls;
+		std::vector<float> spots;
+	};
+	std::vector<Entry> entries;
+
+	// bubbles and drains are x, y pairs in cells
+	template <class Grid>
+	void Add(const Grid& grid, int cellSize, MazeAlgorithm algorithm, uint64_t seed, const std::string& name,
+		const std::vector<float>& bubbles, const std::vector<float>& drains) {
+		Entry e;
+		memset(&e.level, 0, sizeof(e.level));
+		e.level.width = grid.cols;
+		e.level.height = grid.rows;
+		e.level.cellSize = cellSize;
+		e.level.algorithm = (uint32_t)algorithm;
+		e.level.seed = seed;
+		e.level.bubbleCount = (uint32_t)(bubbles.size() / 2);
+		e.level.drainCount = (uint32_t)(drains.size() / 2);
+		memcpy(e.level.name, name.data(), std::min(name.size(), sizeof(e.level.name)));
+		e.walls.assign(grid.words, grid.words + (size_t)grid.wordsPerRow * grid.rows);
+		e.spots = bubbles;
+		e.spots.insert(e.spots.end(), drains.begin(), drains.end());
+		entries.push_back(std::move(e));
+	}
+
+	bool Save(const std::string& file) {
+		MazePackHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, "FEMAZEPK", 8);
+		header.version = MazePack::VERSION;
+		header.levelCount = (uint32_t)entries.size();
+		header.directoryOffset = sizeof(MazePackHeader);
+
+		uint64_t at = header.directoryOffset + entries.size() * sizeof(MazePackLevel);
+		for (auto& e : entries) {
+			e.level.wallsOffset = at;
+			at += e.walls.size() * 8;
+			e.level.spotsOffset = at;
+			at += e.spots.size() * 4; // pairs of floats, so still 8-byte aligned
+		}
+		header.fileSize = at;
+
+		FILE* f = fopen(file.c_str(), "wb");
+		if (!f) return false;
+		bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+		for (auto& e : entries) ok = ok && fwrite(&e.level, sizeof(e.level), 1, f) == 1;
+		for (auto& e : entries) {
+			ok = ok && fwrite(e.walls.data(), 8, e.walls.size(), f) == e.walls.size();
+			ok = ok && fwrite(e.spots.data(), 4, e.spots.size(), f) == e.spots.size();
+		}
+		return fclose(f) == 0 && ok;
+	}
+};
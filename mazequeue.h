@@ -0,0 +1,118 @@
+#pragma once
+// Mazes picked ahead of time on a background thread, so starting a new flood
+// game doesn't generate anything inside the frame. The worker keeps up to
+// CAPACITY mazes ready for the current settings; taking one hands over a
+// pointer, and the worker makes the next while the game plays. No raylib in here.
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+#include "sim.h"
+
+class MazeQueue {
+public:
+	static constexpr int CAPACITY = 2;
+
+	// Seeds for the mazes come from `seed`'s own sequence
+	explicit MazeQueue(uint64_t seed) : seeds(seed, RNG_CANDIDATES) {}
+	MazeQueue(const MazeQueue&) = delete;
+	MazeQueue& operator=(const MazeQueue&) = delete;
+
+	~MazeQueue() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wake.notify_all();
+		if (worker.joinable()) worker.join();
+	}
+
+	// Settings the next games will use. Mazes made for other settings are
+	// dropped; cheap to call every frame when nothing changed.
+	void Configure(const MazeConfig& c, MazeAlgorithm a) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (configured && Matches(c, a)) return;
+			config = c;
+			algorithm = a;
+			configured = true;
+			generation++;
+			for (auto& maze : ready) spare.push_back(std::move(maze));
+			ready.clear();
+			if (!worker.joinable()) worker = std::thread([this] { Loop(); });
+		}
+		wake.notify_one();
+	}
+
+	// A ready maze for these settings, or null if there isn't one (yet)
+	std::unique_ptr<PreparedMaze> Take(const MazeConfig& c, MazeAlgorithm a) {
+		std::unique_ptr<PreparedMaze> maze;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (ready.empty() || !Matches(c, a)) return maze;
+			maze = std::move(ready.front());
+			ready.pop_front();
+		}
+		wake.notify_one();
+		return maze;
+	}
+
+	// Hands a maze back once FloodGame::Start() has swapped it in; it holds the
+	// old game's buffers then, which the worker fills again instead of allocating
+	void Recycle(std::unique_ptr<PreparedMaze> maze) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if ((int)spare.size() < CAPACITY) spare.push_back(std::move(maze));
+	}
+
+	int Ready() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return (int)ready.size();
+	}
+
+private:
+	std::thread worker;
+	std::mutex mutex;             // guards everything below; only held to move pointers
+	std::condition_variable wake;
+	std::deque<std::unique_ptr<PreparedMaze>> ready;
+	std::vector<std::unique_ptr<PreparedMaze>> spare;
+	MazeConfig config;
+	MazeAlgorithm algorithm = MazeAlgorithm::Backtracker;
+	Rng seeds;
+	uint64_t generation = 0;      // bumped when the settings change
+	bool configured = false;
+	bool quit = false;
+
+	bool Matches(const MazeConfig& c, MazeAlgorithm a) const {
+		return c.width == config.width && c.height == config.height && c.cellSize == config.cellSize && a == algorithm;
+	}
+
+	void Loop() {
+		// One maze at a time on this thread alone; the pool stays free for the game
+		ThreadPool::KeepSerial();
+		MazePicker picker;
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;) {
+			wake.wait(lock, [&] { return quit || (int)ready.size() < CAPACITY; });
+			if (quit) return;
+			MazeConfig c = config;
+			MazeAlgorithm a = algorithm;
+			uint64_t seed = seeds.Next();
+			uint64_t made = generation;
+			std::unique_ptr<PreparedMaze> maze;
+			if (!spare.empty()) {
+				maze = std::move(spare.back());
+				spare.pop_back();
+			}
+			lock.unlock();
+
+			if (!maze) maze.reset(new PreparedMaze());
+			picker.Pick(c, a, seed, 1, *maze);
+
+			lock.lock();
+			if (made == generation) ready.push_back(std::move(maze));
+			else if ((int)spare.size() < CAPACITY) spare.push_back(std::move(maze));
+		}
+	}
+};
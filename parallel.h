@@ -0,0 +1,172 @@
+#pragma once
+// Work-stealing thread pool behind ParallelFor, for the batch jobs (tiled maze
+// generation, candidate mazes, rivals, collision batches). Threads are started
+// once and sleep between jobs, so a ParallelFor every tick is cheap.
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+inline int DefaultThreadCount() {
+	unsigned n = std::thread::hardware_concurrency();
+	return n > 0 ? (int)n : 1;
+}
+
+// Each job's items are split into one contiguous range per worker. A worker
+// takes items off the front of its own range; when that runs out it steals the
+// back half of someone else's. A range is begin << 32 | end in one atomic, so
+// taking and stealing are both a single compare-exchange.
+class ThreadPool {
+public:
+	static const int MAX_THREADS = 64;
+
+	ThreadPool() {}
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wake.notify_all();
+		for (auto& t : threads) t.join();
+	}
+
+	// The one pool ParallelFor uses
+	static ThreadPool& Shared() {
+		static ThreadPool pool;
+		return pool;
+	}
+
+	// Runs f(item, worker) for every item in [0, count) on up to `threadCount`
+	// threads, the caller being worker 0. Which worker gets which item varies
+	// between runs; f must not depend on it for anything but scratch space.
+	// Called from inside a job, or while another thread has the pool, it just
+	// runs everything on the calling thread.
+	template <class F>
+	void Run(int count, int threadCount, F&& f) {
+		int workers = std::max(1, std::min({ threadCount, count, MAX_THREADS }));
+		std::unique_lock<std::mutex> job(jobMutex, std::defer_lock);
+		if (workers == 1 || InsideJob() || !job.try_lock()) {
+			for (int i = 0; i < count; i++) f(i, 0);
+			return;
+		}
+		while ((int)threads.size() < workers - 1) {
+			int index = (int)threads.size() + 1;
+			threads.emplace_back([this, index] { WorkerLoop(index); });
+		}
+
+		for (int w = 0; w < workers; w++) {
+			uint64_t begin = (uint64_t)count * w / workers;
+			uint64_t end = (uint64_t)count * (w + 1) / workers;
+			ranges[w].bounds.store(begin << 32 | end);
+		}
+		using Fn = typename std::remove_reference<F>::type;
+		context = (void*)&f;
+		call = [](void* ctx, int item, int worker) { (*(Fn*)ctx)(item, worker); };
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			participants = workers;
+			running = workers - 1;
+			generation++;
+		}
+		wake.notify_all();
+
+		InsideJob() = true;
+		Work(0);
+		InsideJob() = false;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&] { return running == 0; });
+	}
+
+	// Every job started from the calling thread from now on runs on that thread
+	// alone, as if nested. For background threads that mustn't take the pool
+	// away from the game's own jobs.
+	static void KeepSerial() { InsideJob() = true; }
+
+private:
+	struct alignas(64) Range {
+		std::atomic<uint64_t> bounds{ 0 };
+	};
+
+	Range ranges[MAX_THREADS];
+	std::vector<std::thread> threads;
+	std::mutex jobMutex;          // one job at a time
+	std::mutex mutex;             // guards the fields below
+	std::condition_variable wake, done;
+	uint64_t generation = 0;
+	int participants = 0;
+	int running = 0;              // pool threads still working on this job
+	bool quit = false;
+	void* context = nullptr;
+	void (*call)(void*, int, int) = nullptr;
+
+	static bool& InsideJob() {
+		thread_local bool inside = false;
+		return inside;
+	}
+
+	void WorkerLoop(int index) {
+		InsideJob() = true;
+		uint64_t seen = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return quit || (generation != seen && index < participants); });
+				if (quit) return;
+				seen = generation;
+			}
+			Work(index);
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--running == 0) done.notify_one();
+		}
+	}
+
+	void Work(int worker) {
+		const int workers = participants;
+		for (;;) {
+			// Own range, from the front
+			std::atomic<uint64_t>& own = ranges[worker].bounds;
+			uint64_t b = own.load();
+			while ((uint32_t)(b >> 32) < (uint32_t)b) {
+				uint32_t item = (uint32_t)(b >> 32);
+				if (own.compare_exchange_weak(b, b + (1ull << 32))) {
+					call(context, (int)item, worker);
+					b = own.load();
+				}
+			}
+
+			// Out of work: steal the back half of the next busy range. Every item
+			// is claimed by exactly one of these exchanges, so once nothing is
+			// left to steal anywhere, this worker is done.
+			bool stole = false;
+			for (int k = 1; k < workers && !stole; k++) {
+				std::atomic<uint64_t>& victim = ranges[(worker + k) % workers].bounds;
+				uint64_t v = victim.load();
+				for (;;) {
+					uint32_t begin = (uint32_t)(v >> 32), end = (uint32_t)v;
+					if (begin >= end) break;
+					uint32_t mid = end - (end - begin + 1) / 2;
+					if (victim.compare_exchange_weak(v, (uint64_t)begin << 32 | mid)) {
+						own.store((uint64_t)mid << 32 | end);
+						stole = true;
+						break;
+					}
+				}
+			}
+			if (!stole) return;
+		}
+	}
+};
+
+// Runs f(item, worker) for every item in [0, count) on the shared pool, see ThreadPool::Run
+template <class F>
+void ParallelFor(int count, int threads, F&& f) {
+	ThreadPool::Shared().Run(count, threads, f);
+}
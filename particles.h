@@ -0,0 +1,76 @@
+#pragma once
+// Ambient background particles, simulation only (drawing is in code.cpp).
+// Stored as structure-of-arrays so the per-frame move is a straight loop over
+// floats the compiler can vectorise; respawns are rare and handled in a second pass.
+#include <vector>
+#include <cstdint>
+#include "rng.h"
+
+class ParticleField {
+public:
+	static const int PALETTE_SIZE = 4;
+
+	int count = 0;
+	float width = 800, height = 600;
+	std::vector<float> x, y;
+	std::vector<float> vx, vy;     // per frame; vx includes the sideways drift
+	std::vector<float> size;       // core radius in pixels
+	std::vector<float> alpha;
+	std::vector<uint8_t> color;    // palette index
+	Rng rng;
+
+	void Init(int n, int screenWidth, int screenHeight, uint64_t seed) {
+		Resize(screenWidth, screenHeight);
+		rng = Rng(seed, RNG_PARTICLES);
+		count = n;
+		x.resize(n); y.resize(n);
+		vx.resize(n); vy.resize(n);
+		size.resize(n); alpha.resize(n);
+		color.resize(n);
+		for (int i = 0; i < n; i++) {
+			Spawn(i, Unit() * height);
+			size[i] = NextBelow(4) + 1.5f;
+			alpha[i] = Unit() * 0.7f + 0.1f;
+			color[i] = (uint8_t)NextBelow(PALETTE_SIZE);
+		}
+	}
+
+	void Resize(int screenWidth, int screenHeight) {
+		width = screenWidth > 0 ? (float)screenWidth : 800;
+		height = screenHeight > 0 ? (float)screenHeight : 600;
+	}
+
+	void Update() {
+		float* px = x.data();
+		float* py = y.data();
+		const float* pvx = vx.data();
+		const float* pvy = vy.data();
+		for (int i = 0; i < count; i++) {
+			px[i] += pvx[i];
+			py[i] += pvy[i];
+		}
+
+		// Off the top or the sides: back in just below the bottom edge.
+		// `|` rather than `||` so the test is one branch that's almost never taken
+		const float right = width + 20;
+		for (int i = 0; i < count; i++) {
+			if ((py[i] < -20) | (px[i] < -20) | (px[i] > right)) {
+				Spawn(i, height + NextBelow(50));
+			}
+		}
+	}
+
+private:
+	void Spawn(int i, float startY) {
+		x[i] = NextBelow((uint32_t)width);
+		y[i] = startY;
+		// The old Particle drifted by sin(life * 0.02f) * 0.3f each frame, but life
+		// was never set or advanced, so it was a fixed random nudge; fold it into vx
+		float drift = (Unit() * 2 - 1) * 0.3f;
+		vx[i] = (NextBelow(100) - 50.0f) / 50.0f + drift;
+		vy[i] = -(NextBelow(50) + 20.0f) / 30.0f;
+	}
+
+	uint32_t NextBelow(uint32_t n) { return rng.Below(n); }
+	float Unit() { return (rng.Next() >> 40) * (1.0f / 16777216.0f); }
+};
@@ -0,0 +1,102 @@
+#pragma once
+// Per-cell index of things lying in the maze (air bubbles, drain switches, ...)
+// so proximity checks only look at the player's cell and its neighbours.
+// Buckets are packed CSR style: one items array grouped by cell plus an offset
+// per cell, built once at Reset(). Removing an item just shrinks its bucket.
+#include <vector>
+#include <algorithm>
+
+class PickupIndex {
+public:
+	int cols = 0;
+	int rows = 0;
+	int cellSize = 20;
+	int live = 0;
+	std::vector<int> bucketStart;  // cols * rows + 1 offsets into items
+	std::vector<int> bucketLive;   // live items in each bucket, packed at its start
+	std::vector<int> items;        // item ids grouped by cell
+	std::vector<int> slot;         // position of each item id in items
+	std::vector<int> itemCell;
+
+	// Item needs float x, y in pixels
+	template <class Item>
+	void Build(int c, int r, int cs, const std::vector<Item>& list) {
+		cols = c;
+		rows = r;
+		cellSize = cs;
+		live = (int)list.size();
+		bucketStart.assign(cols * rows + 1, 0);
+		bucketLive.assign(cols * rows, 0);
+		itemCell.resize(list.size());
+		for (size_t i = 0; i < list.size(); i++) {
+			itemCell[i] = CellAt(list[i].x, list[i].y);
+			bucketLive[itemCell[i]]++;
+		}
+		for (int cell = 0; cell < cols * rows; cell++) {
+			bucketStart[cell + 1] = bucketStart[cell] + bucketLive[cell];
+		}
+
+		items.resize(list.size());
+		slot.resize(list.size());
+		std::fill(bucketLive.begin(), bucketLive.end(), 0);
+		for (size_t i = 0; i < list.size(); i++) {
+			int cell = itemCell[i];
+			int s = bucketStart[cell] + bucketLive[cell]++;
+			items[s] = (int)i;
+			slot[i] = s;
+		}
+	}
+
+	int CellAt(float x, float y) const {
+		int cx = std::min(std::max((int)(x / cellSize), 0), cols - 1);
+		int cy = std::min(std::max((int)(y / cellSize), 0), rows - 1);
+		return cx + cy * cols;
+	}
+
+	// Calls f(item) for every live item in the cells the circle (x, y, radius)
+	// touches: one to four cells for a radius up to half a cell. radius must not
+	// exceed cellSize. Floors are done as (int)(v + 1) - 1, fine for v >= -1 and
+	// much cheaper than a floorf() call.
+	template <class F>
+	void ForEachNear(float x, float y, float radius, F&& f) const {
+		const float inv = 1.0f / cellSize;
+		int x0 = std::max((int)((x - radius) * inv + 1) - 1, 0);
+		int x1 = std::min((int)((x + radius) * inv + 1) - 1, cols - 1);
+		int y0 = std::max((int)((y - radius) * inv + 1) - 1, 0);
+		int y1 = std::min((int)((y + radius) * inv + 1) - 1, rows - 1);
+		ForEachIn(x0, y0, x1 + 1, y1 + 1, f);
+	}
+
+	// Calls f(item) for every live item in cells [x0, x1) x [y0, y1), which
+	// must lie inside the grid; the renderer uses it for what's on screen
+	template <class F>
+	void ForEachIn(int x0, int y0, int x1, int y1, F&& f) const {
+		for (int ny = y0; ny < y1; ny++) {
+			for (int nx = x0; nx < x1; nx++) {
+				int n = nx + ny * cols;
+				for (int s = bucketStart[n], end = s + bucketLive[n]; s < end; s++) f(items[s]);
+			}
+		}
+	}
+
+	// Drops an item from its bucket (swap with the bucket's last live item)
+	void Remove(int item) {
+		int cell = itemCell[item];
+		int s = slot[item];
+		int last = bucketStart[cell] + --bucketLive[cell];
+		int other = items[last];
+		items[s] = other;
+		slot[other] = s;
+		items[last] = item;
+		slot[item] = last;
+		live--;
+	}
+
+	// The owner swap-removed its vector: the item called `from` is now called `to`
+	// (`to` must already be removed from the index)
+	void Renumber(int from, int to) {
+		items[slot[from]] = to;
+		slot[to] = slot[from];
+		itemCell[to] = itemCell[from];
+	}
+};
@@ -0,0 +1,237 @@
+#pragma once
+// Frame profiler: scoped timing zones around the phases of a frame, recorded
+// into a lock-free ring buffer any thread can write to. Once a frame the main
+// thread folds that frame's events into per-phase totals for the overlay
+// (min / avg / p99 over the last HISTORY frames, and draws issued), and the
+// raw events can be written out as CSV or as a Chrome trace (chrome://tracing,
+// ui.perfetto.dev). No raylib in here; code.cpp draws the overlay.
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+
+// The phases that get timed. Zones nest: ticks contains player / water / rivals.
+enum ProfileZoneId {
+	PROFILE_FRAME = 0,
+	PROFILE_MUSIC,
+	PROFILE_TICKS,            // all fixed ticks due this frame
+	PROFILE_PLAYER,           // FloodGame::Step parts
+	PROFILE_WATER,
+	PROFILE_RIVALS,
+	PROFILE_PARTICLES_UPDATE,
+	PROFILE_PARTICLES_DRAW,
+	PROFILE_MAZE_CACHE,       // redrawing the cached walls after a new maze
+	PROFILE_MAZE_DRAW,
+	PROFILE_WATER_DRAW,
+	PROFILE_WATER_UI,
+	PROFILE_ACTORS_DRAW,      // player, rivals, hint
+	PROFILE_MINIMAP,          // uploading the changed parts, drawing it
+	PROFILE_PRESENT,          // EndDrawing: flushing the batch and waiting for vsync
+	PROFILE_ZONE_COUNT
+};
+
+inline const char* ProfileZoneName(int zone) {
+	static const char* const names[PROFILE_ZONE_COUNT] = {
+		"frame", "music", "ticks", "player", "water", "rivals", "particles.update", "particles.draw",
+		"maze.cache", "maze.draw", "water.draw", "water.ui", "actors.draw", "minimap", "present",
+	};
+	return zone >= 0 && zone < PROFILE_ZONE_COUNT ? names[zone] : "?";
+}
+
+// One finished zone
+struct ProfileEvent {
+	uint64_t start = 0;    // ns since the profiler started
+	uint32_t duration = 0; // ns
+	uint16_t zone = 0;
+	uint16_t thread = 0;
+	uint32_t draws = 0;
+	uint32_t frame = 0;
+};
+
+class Profiler {
+public:
+	static constexpr int CAPACITY = 1 << 16;  // events kept for export, about a minute of frames
+	static constexpr int HISTORY = 240;       // frames the overlay stats cover
+
+	struct ZoneStats {
+		float minMs = 0, avgMs = 0, p99Ms = 0;
+		float draws = 0;  // average per frame
+		int frames = 0;   // frames of the last HISTORY it ran in
+	};
+
+	std::atomic<bool> enabled{ false };  // the game turns it on; headless runs don't pay for it
+
+	static Profiler& Get() {
+		static Profiler profiler;
+		return profiler;
+	}
+
+	uint64_t Now() const {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	// Lock-free from any thread: claim a slot, write it, then publish it with
+	// its sequence number. A slot being rewritten is skipped by readers.
+	void Record(int zone, uint64_t start, uint64_t end, uint32_t draws) {
+		uint64_t n = head.fetch_add(1, std::memory_order_relaxed);
+		Slot& slot = slots[n & (CAPACITY - 1)];
+		slot.sequence.store(n * 2 + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		uint64_t duration = std::min<uint64_t>(end - start, UINT32_MAX);
+		slot.start.store(start, std::memory_order_relaxed);
+		slot.packed.store(duration | (uint64_t)zone << 32 | (uint64_t)ThreadIndex() << 48, std::memory_order_relaxed);
+		slot.counts.store(draws | (uint64_t)frame.load(std::memory_order_relaxed) << 32, std::memory_order_relaxed);
+		slot.sequence.store(n * 2 + 2, std::memory_order_release);
+	}
+
+	// Main thread, after the frame's last zone: folds the frame's events into the stats
+	void EndFrame() {
+		uint64_t end = head.load(std::memory_order_acquire);
+		uint64_t from = std::max(scanned, end > CAPACITY ? end - CAPACITY : 0);
+		double ms[PROFILE_ZONE_COUNT] = {};
+		uint32_t draws[PROFILE_ZONE_COUNT] = {};
+		bool ran[PROFILE_ZONE_COUNT] = {};
+		ProfileEvent e;
+		for (uint64_t n = from; n < end; n++) {
+			if (!Read(n, e)) continue;
+			ms[e.zone] += e.duration / 1e6;
+			draws[e.zone] += e.draws;
+			ran[e.zone] = true;
+		}
+		scanned = end;
+
+		int at = (int)(frame.load(std::memory_order_relaxed) % HISTORY);
+		for (int z = 0; z < PROFILE_ZONE_COUNT; z++) {
+			history[z][at] = ran[z] ? (float)ms[z] : -1.0f;
+			drawHistory[z][at] = draws[z];
+		}
+		frame.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	ZoneStats Stats(int zone) const {
+		ZoneStats stats;
+		float times[HISTORY];
+		double sum = 0, drawSum = 0;
+		for (int i = 0; i < HISTORY; i++) {
+			if (history[zone][i] < 0) continue;
+			times[stats.frames++] = history[zone][i];
+			sum += history[zone][i];
+			drawSum += drawHistory[zone][i];
+		}
+		if (stats.frames == 0) return stats;
+		std::sort(times, times + stats.frames);
+		stats.minMs = times[0];
+		stats.avgMs = (float)(sum / stats.frames);
+		stats.p99Ms = times[std::max(0, (stats.frames * 99 + 99) / 100 - 1)];
+		stats.draws = (float)(drawSum / stats.frames);
+		return stats;
+	}
+
+	// The events still in the ring, oldest first
+	std::vector<ProfileEvent> Events() const {
+		std::vector<ProfileEvent> events;
+		uint64_t end = head.load(std::memory_order_acquire);
+		ProfileEvent e;
+		for (uint64_t n = end > CAPACITY ? end - CAPACITY : 0; n < end; n++) {
+			if (Read(n, e)) events.push_back(e);
+		}
+		return events;
+	}
+
+	bool SaveCsv(const std::string& path) const {
+		FILE* f = fopen(path.c_str(), "w");
+		if (!f) return false;
+		fprintf(f, "frame,thread,zone,start_us,duration_us,draws\n");
+		for (const ProfileEvent& e : Events()) {
+			fprintf(f, "%u,%u,%s,%.3f,%.3f,%u\n", e.frame, e.thread, ProfileZoneName(e.zone),
+				e.start / 1e3, e.duration / 1e3, e.draws);
+		}
+		return fclose(f) == 0;
+	}
+
+	// Chrome trace event format: one complete ("X") event per zone, times in us
+	bool SaveChromeTrace(const std::string& path) const {
+		FILE* f = fopen(path.c_str(), "w");
+		if (!f) return false;
+		fprintf(f, "{\"traceEvents\":[\n");
+		bool first = true;
+		for (const ProfileEvent& e : Events()) {
+			fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+				"\"args\":{\"frame\":%u,\"draws\":%u}}", first ? "" : ",\n", ProfileZoneName(e.zone), e.thread,
+				e.start / 1e3, e.duration / 1e3, e.frame, e.draws);
+			first = false;
+		}
+		fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+		return fclose(f) == 0;
+	}
+
+private:
+	struct alignas(32) Slot {
+		std::atomic<uint64_t> sequence{ 0 };  // 2n + 2 once event n is written, odd while writing
+		std::atomic<uint64_t> start{ 0 };
+		std::atomic<uint64_t> packed{ 0 };    // duration | zone << 32 | thread << 48
+		std::atomic<uint64_t> counts{ 0 };    // draws | frame << 32
+	};
+
+	std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	std::vector<Slot> slots = std::vector<Slot>(CAPACITY);
+	std::atomic<uint64_t> head{ 0 };
+	std::atomic<uint32_t> frame{ 0 };
+	uint64_t scanned = 0;                           // main thread only, like the history
+	float history[PROFILE_ZONE_COUNT][HISTORY] = {};
+	uint32_t drawHistory[PROFILE_ZONE_COUNT][HISTORY] = {};
+
+	Profiler() {
+		for (auto& zone : history) std::fill(zone, zone + HISTORY, -1.0f);
+	}
+
+	bool Read(uint64_t n, ProfileEvent& e) const {
+		const Slot& slot = slots[n & (CAPACITY - 1)];
+		uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+		if (sequence != n * 2 + 2) return false;
+		uint64_t start = slot.start.load(std::memory_order_relaxed);
+		uint64_t packed = slot.packed.load(std::memory_order_relaxed);
+		uint64_t counts = slot.counts.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != sequence) return false;
+		e.start = start;
+		e.duration = (uint32_t)packed;
+		e.zone = (uint16_t)(packed >> 32);
+		e.thread = (uint16_t)(packed >> 48);
+		e.draws = (uint32_t)counts;
+		e.frame = (uint32_t)(counts >> 32);
+		return e.zone < PROFILE_ZONE_COUNT;
+	}
+
+	static uint16_t ThreadIndex() {
+		static std::atomic<uint16_t> next{ 0 };
+		thread_local uint16_t index = next.fetch_add(1);
+		return index;
+	}
+};
+
+// Times the enclosing scope as one zone. Draws() adds to the draw calls it issued.
+class ProfileScope {
+public:
+	explicit ProfileScope(int z) : zone(z) {
+		Profiler& profiler = Profiler::Get();
+		if (profiler.enabled.load(std::memory_order_relaxed)) start = profiler.Now();
+	}
+
+	~ProfileScope() {
+		if (start == ~0ull) return;
+		Profiler& profiler = Profiler::Get();
+		profiler.Record(zone, start, profiler.Now(), draws);
+	}
+
+	void Draws(uint32_t n) { draws += n; }
+
+private:
+	int zone;
+	uint64_t start = ~0ull;
+	uint32_t draws = 0;
+};
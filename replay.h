@@ -0,0 +1,178 @@
+#pragma once
+// Replays: everything needed to play a run again bit for bit. That's the game
+// settings, the seed and the input bitmask of every tick, plus a hash of the
+// game state once a second so a replay shows where a changed simulation first
+// goes a different way. FloodGame and EndlessGame record one on every run.
+//
+// File layout, all little-endian:
+//   "FERP" u8 version, u8 mode, u8 algorithm, u8 0
+//   u32 width, height, cellSize, rivalCount   u64 seed   u32 ticks
+//   u32 runs, then per run: u8 input, varint length
+//   u32 checkpoints, then a u32 state hash each
+//   u32 pack path length, the path, u32 pack level (length 0: generated maze)
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include "maze.h"
+#include "mazegen.h"
+
+enum class ReplayMode : uint8_t { Flood, Endless };
+
+class Replay {
+public:
+	// 2: Philox RNG streams, version 1 games play differently. 3: maze packs.
+	// 4: the stricter maze check picks other mazes for the same seed.
+	static const uint8_t VERSION = 4;
+
+	ReplayMode mode = ReplayMode::Flood;
+	MazeConfig config;
+	MazeAlgorithm algorithm = MazeAlgorithm::Backtracker;
+	int rivalCount = 0;
+	uint64_t seed = 0;
+	std::vector<uint8_t> inputs;        // one per tick
+	std::vector<uint32_t> checkpoints;  // state hash after every TICK_RATE ticks
+	std::string packPath;               // set when played on a maze pack level
+	int packLevel = -1;
+
+	void Begin(ReplayMode m, const MazeConfig& c, MazeAlgorithm a, int rivals, uint64_t s) {
+		mode = m;
+		config = c;
+		algorithm = a;
+		rivalCount = rivals;
+		seed = s;
+		inputs.clear();
+		checkpoints.clear();
+		packPath.clear();
+		packLevel = -1;
+	}
+
+	int Ticks() const { return (int)inputs.size(); }
+
+	// Past the end of the recording nothing is pressed
+	uint8_t InputAt(int tick) const {
+		return tick < (int)inputs.size() ? inputs[tick] : 0;
+	}
+
+	// Inputs are run-length coded: held keys repeat for dozens of ticks at a time
+	std::vector<uint8_t> Encode() const {
+		std::vector<uint8_t> out = { 'F', 'E', 'R', 'P', VERSION, (uint8_t)mode, (uint8_t)algorithm, 0 };
+		Put32(out, config.width);
+		Put32(out, config.height);
+		Put32(out, config.cellSize);
+		Put32(out, rivalCount);
+		Put32(out, (uint32_t)seed);
+		Put32(out, (uint32_t)(seed >> 32));
+		Put32(out, Ticks());
+
+		size_t runCountAt = out.size();
+		Put32(out, 0);
+		uint32_t runs = 0;
+		for (size_t i = 0; i < inputs.size();) {
+			size_t end = i;
+			while (end < inputs.size() && inputs[end] == inputs[i]) end++;
+			out.push_back(inputs[i]);
+			for (uint64_t length = end - i; ; length >>= 7) {
+				out.push_back((uint8_t)(length & 0x7F) | (length >= 0x80 ? 0x80 : 0));
+				if (length < 0x80) break;
+			}
+			runs++;
+			i = end;
+		}
+		for (int b = 0; b < 4; b++) out[runCountAt + b] = (uint8_t)(runs >> (b * 8));
+
+		Put32(out, (uint32_t)checkpoints.size());
+		for (uint32_t hash : checkpoints) Put32(out, hash);
+
+		Put32(out, (uint32_t)packPath.size());
+		out.insert(out.end(), packPath.begin(), packPath.end());
+		Put32(out, (uint32_t)packLevel);
+		return out;
+	}
+
+	// False on anything that isn't a complete replay of this version
+	bool Decode(const std::vector<uint8_t>& in) {
+		size_t at = 8;
+		if (in.size() < at || in[0] != 'F' || in[1] != 'E' || in[2] != 'R' || in[3] != 'P' || in[4] != VERSION) return false;
+		if (in[5] > (uint8_t)ReplayMode::Endless || in[6] >= (uint8_t)MazeAlgorithm::Count) return false;
+		mode = (ReplayMode)in[5];
+		algorithm = (MazeAlgorithm)in[6];
+
+		uint32_t width, height, cellSize, rivals, seedLow, seedHigh, ticks, runs, count;
+		if (!Get32(in, at, width) || !Get32(in, at, height) || !Get32(in, at, cellSize) || !Get32(in, at, rivals)
+			|| !Get32(in, at, seedLow) || !Get32(in, at, seedHigh) || !Get32(in, at, ticks) || !Get32(in, at, runs)) {
+			return false;
+		}
+		config.width = (int)width;
+		config.height = (int)height;
+		config.cellSize = (int)cellSize;
+		rivalCount = (int)rivals;
+		seed = (uint64_t)seedHigh << 32 | seedLow;
+
+		inputs.clear();
+		for (uint32_t r = 0; r < runs; r++) {
+			if (at >= in.size()) return false;
+			uint8_t input = in[at++];
+			uint64_t length = 0;
+			for (int shift = 0; ; shift += 7) {
+				if (at >= in.size() || shift > 28) return false;
+				uint8_t byte = in[at++];
+				length |= (uint64_t)(byte & 0x7F) << shift;
+				if (!(byte & 0x80)) break;
+			}
+			if (inputs.size() + length > ticks) return false;
+			inputs.insert(inputs.end(), length, input);
+		}
+		if (inputs.size() != ticks || !Get32(in, at, count) || in.size() - at < (uint64_t)count * 4) return false;
+		checkpoints.resize(count);
+		for (auto& hash : checkpoints) Get32(in, at, hash);
+
+		uint32_t pathLength, level;
+		if (!Get32(in, at, pathLength) || in.size() - at < pathLength) return false;
+		packPath.assign(in.begin() + at, in.begin() + at + pathLength);
+		at += pathLength;
+		if (!Get32(in, at, level)) return false;
+		packLevel = (int)level;
+		return true;
+	}
+
+	bool Save(const std::string& path) const {
+		std::vector<uint8_t> bytes = Encode();
+		FILE* f = fopen(path.c_str(), "wb");
+		if (!f) return false;
+		bool ok = fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+		return fclose(f) == 0 && ok;
+	}
+
+	bool Load(const std::string& path) {
+		FILE* f = fopen(path.c_str(), "rb");
+		if (!f) return false;
+		std::vector<uint8_t> bytes;
+		uint8_t buffer[4096];
+		for (size_t n; (n = fread(buffer, 1, sizeof(buffer), f)) > 0;) bytes.insert(bytes.end(), buffer, buffer + n);
+		fclose(f);
+		return Decode(bytes);
+	}
+
+private:
+	static void Put32(std::vector<uint8_t>& out, uint32_t v) {
+		for (int b = 0; b < 4; b++) out.push_back((uint8_t)(v >> (b * 8)));
+	}
+
+	static bool Get32(const std::vector<uint8_t>& in, size_t& at, uint32_t& v) {
+		if (in.size() - at < 4) return false;
+		v = 0;
+		for (int b = 0; b < 4; b++) v |= (uint32_t)in[at++] << (b * 8);
+		return true;
+	}
+};
+
+// FNV-1a over raw bytes, for the checkpoint hashes
+inline uint32_t HashBytes(uint32_t h, const void* data, size_t len) {
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < len; i++) {
+		h ^= bytes[i];
+		h *= 16777619u;
+	}
+	return h;
+}
@@ -0,0 +1,85 @@
+#pragma once
+// Small, fast RNG owned by whoever needs randomness (maze generators etc.)
+// instead of the shared libc rand().
+//
+// Counter-based (Philox4x32-10, as in Random123): output i of a stream is a
+// pure function of (seed, stream, i), not of earlier outputs. So one 64-bit seed
+// splits into independent streams per subsystem and per tile without anything
+// being shared between threads, and Skip() jumps ahead for free. Integer-only,
+// so a seed gives the same numbers on every machine.
+#include <cstdint>
+
+// Stream ids under a seed. Tiles of the tiled generator use RNG_TILE + tile.
+enum RngStream : uint64_t {
+	RNG_MAIN = 0,
+	RNG_CANDIDATES,  // one seed per candidate maze in FloodGame::NewGame
+	RNG_MAZE,        // maze generator
+	RNG_WATER,       // bubble placement
+	RNG_RIVALS,
+	RNG_ENDLESS,
+	RNG_PARTICLES,
+	RNG_STITCH,      // joining tiles in TiledGenerator
+	RNG_TILE = 1ull << 32,
+};
+
+class Rng {
+public:
+	uint64_t seed = 0;
+	uint64_t stream = 0;
+	uint64_t counter = 0;  // 32-bit words drawn so far
+
+	explicit Rng(uint64_t s = 0, uint64_t st = RNG_MAIN) : seed(s), stream(st) {}
+
+	// Another stream under the same seed
+	Rng Stream(uint64_t st) const { return Rng(seed, st); }
+
+	// Each block is four 32-bit words; the generators mostly want Below(), which
+	// only needs one, so a block lasts four draws
+	uint32_t Next32() {
+		uint64_t block = counter >> 2;
+		if (block != bufferedBlock) {
+			Block(block, buffered);
+			bufferedBlock = block;
+		}
+		return buffered[counter++ & 3];
+	}
+
+	uint64_t Next() {
+		uint64_t low = Next32();
+		return (uint64_t)Next32() << 32 | low;
+	}
+
+	void Skip(uint64_t words) { counter += words; }
+
+	// Uniform-enough integer in [0, n) without a division
+	uint32_t Below(uint32_t n) {
+		return (uint32_t)(((uint64_t)Next32() * n) >> 32);
+	}
+
+	// One Philox4x32-10 block: 128 bits out for counter (block, stream), key seed
+	void Block(uint64_t block, uint32_t out[4]) const {
+		uint32_t c0 = (uint32_t)block, c1 = (uint32_t)(block >> 32);
+		uint32_t c2 = (uint32_t)stream, c3 = (uint32_t)(stream >> 32);
+		uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+		for (int round = 0; round < 10; round++) {
+			uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+			uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+			uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+			uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+			c1 = (uint32_t)p1;
+			c3 = (uint32_t)p0;
+			c0 = n0;
+			c2 = n2;
+			k0 += 0x9E3779B9u;
+			k1 += 0xBB67AE85u;
+		}
+		out[0] = c0;
+		out[1] = c1;
+		out[2] = c2;
+		out[3] = c3;
+	}
+
+private:
+	uint32_t buffered[4] = { 0, 0, 0, 0 };
+	uint64_t bufferedBlock = ~0ull;
+};
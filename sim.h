@@ -0,0 +1,702 @@
+#pragma once
+// Flood Escape game logic. No raylib in here: input comes in as a bitmask and
+// time advances in fixed ticks, so a whole game can be stepped without a window.
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include "maze.h"
+#include "mazegen.h"
+#include "solver.h"
+#include "flood.h"
+#include "survive.h"
+#include "pickups.h"
+#include "collision.h"
+#include "parallel.h"
+#include "replay.h"
+#include "mazepack.h"
+#include "profiler.h"
+
+// The game was tuned at 60 FPS with per-frame speeds, so one tick == one of those frames.
+const int TICK_RATE = 60;
+const float TICK_DT = 1.0f / TICK_RATE;
+
+// Turns real frame times into whole fixed ticks, so the game plays the same
+// whatever the render rate. The remainder carries over to the next frame, and
+// Alpha() is how far the renderer is between the last two ticks. Stalls
+// (loading, dragging the window) are cut to MAX_FRAME so the game doesn't try
+// to catch up on seconds of ticks in one go.
+class TickClock {
+public:
+	static constexpr float MAX_FRAME = 0.25f;
+	float accumulator = 0;
+	bool skipNext = false;
+
+	// Call after something slow like NewGame(): the next frame time includes
+	// it and is dropped, so the new game starts at tick 0 instead of a burst
+	void Reset() {
+		accumulator = 0;
+		skipNext = true;
+	}
+
+	int Advance(float frameSeconds) {
+		if (skipNext) {
+			skipNext = false;
+			return 0;
+		}
+		accumulator += std::min(std::max(frameSeconds, 0.0f), MAX_FRAME);
+		int ticks = (int)(accumulator / TICK_DT);
+		accumulator -= ticks * TICK_DT;
+		return ticks;
+	}
+
+	float Alpha() const { return std::min(accumulator / TICK_DT, 1.0f); }
+};
+
+enum InputBits : uint8_t {
+	INPUT_UP = 1 << 0,
+	INPUT_DOWN = 1 << 1,
+	INPUT_LEFT = 1 << 2,
+	INPUT_RIGHT = 1 << 3,
+};
+
+class WaterSystem {
+public:
+	FloodField flood;         // Water depth per cell
+	float riseSpeed = 0.3f;   // Pixels per tick
+	float oxygenLevel = 100.0f;
+	float oxygenDepletionRate = 0.15f;
+	bool isPlayerUnderwater = false;
+	int cellSize = 20;
+
+	struct AirBubble {
+		float x, y;
+	};
+
+	struct DrainSwitch {
+		float x, y;
+		bool activated;
+		float activationRadius; // How close player must be to activate
+	};
+
+	std::vector<AirBubble> airBubbles;     // only the ones not collected yet
+	std::vector<DrainSwitch> drainSwitches;
+	PickupIndex bubbleIndex;  // airBubbles by cell
+	PickupIndex drainIndex;   // drains not switched on yet, by cell
+	int activeDrains = 0;
+	std::vector<int> hits;
+	float waveOffset = 0;
+
+	WaterSystem() {
+		Rng rng;
+		Reset(MazeConfig(), rng);
+	}
+
+	void Reset(const MazeConfig& config, Rng& rng) { // This is when starting new game to reset everything.
+		const int width = config.width;
+		const int height = config.height;
+		Start(config);
+
+		// Placing air bubbles randomly in maze, 8 per 20x20
+		int bubbleCount = std::max(8, width * height / 50);
+		for (int i = 0; i < bubbleCount; i++) {
+			AirBubble bubble;
+			bubble.x = rng.Below(width) * cellSize + cellSize / 2;
+			bubble.y = rng.Below(height) * cellSize + cellSize / 2;
+			airBubbles.push_back(bubble);
+		}
+
+		// Placing 3 drain switches at strategic locations
+		DrainSwitch drain1 = {
+			cellSize*2.5f,
+			cellSize*2.5f,
+			false,
+			(float)cellSize
+		};
+		DrainSwitch drain2 = {
+			cellSize * (width - 2.5f),
+			cellSize * (height - 2.5f),
+			false,
+			(float)cellSize
+		};
+		DrainSwitch drain3 = {
+			(float)(cellSize * (width / 2)),
+			(float)(cellSize * (height / 2)),
+			false,
+			(float)cellSize
+		};
+
+		drainSwitches.push_back(drain1);
+		drainSwitches.push_back(drain2);
+		drainSwitches.push_back(drain3);
+
+		BuildIndices(config);
+	}
+
+	// Same, with the bubbles and drains where a maze pack level has them:
+	// x, y pairs in cells (2.5 is the middle of the third cell)
+	void Reset(const MazeConfig& config, const float* bubbles, int bubbleCount, const float* drains, int drainCount) {
+		Start(config);
+		for (int i = 0; i < bubbleCount; i++) {
+			airBubbles.push_back({ bubbles[i * 2] * cellSize, bubbles[i * 2 + 1] * cellSize });
+		}
+		for (int i = 0; i < drainCount; i++) {
+			drainSwitches.push_back({ drains[i * 2] * cellSize, drains[i * 2 + 1] * cellSize, false, (float)cellSize });
+		}
+		BuildIndices(config);
+	}
+
+	void Start(const MazeConfig& config) {
+		cellSize = config.cellSize;
+		riseSpeed = cellSize * 0.015f; // 0.3 px per tick at the original 20 px cells
+
+		flood.Reset(config.width, config.height);
+		oxygenLevel = 100.0f;
+		isPlayerUnderwater = false;
+		airBubbles.clear();
+		drainSwitches.clear();
+	}
+
+	void BuildIndices(const MazeConfig& config) {
+		bubbleIndex.Build(config.width, config.height, cellSize, airBubbles);
+		drainIndex.Build(config.width, config.height, cellSize, drainSwitches);
+		activeDrains = 0;
+	}
+
+	template <class Grid>
+	void Update(const Grid& grid, float playerX, float playerY, float deltaTime) {
+		waveOffset += deltaTime * 50;
+		if (waveOffset > 360) waveOffset -= 360;
+
+		// Water fills each cell at the speed the old flat water rose; drains slow it or pull it back
+		float rate = riseSpeed / cellSize * FloodField::FULL;
+		if (activeDrains == 1) {
+			rate *= 0.3f; // Slower rise
+		}
+		else if (activeDrains == 2) {
+			rate *= -0.2f; // Slowly drains
+		}
+		else if (activeDrains >= 3) {
+			rate *= -1.5f; // Fast drain with all switches
+		}
+		flood.Update(grid, rate);
+
+		// Check if player is underwater: below the water surface in their own cell
+		int gridX = std::min(std::max((int)(playerX / cellSize), 0), flood.cols - 1);
+		int gridY = std::min(std::max((int)(playerY / cellSize), 0), flood.rows - 1);
+		float waterTopY = (gridY + flood.Surface(gridX, gridY)) * cellSize;
+		isPlayerUnderwater = (playerY > waterTopY);
+
+		// Update oxygen
+		if (isPlayerUnderwater) {
+			oxygenLevel -= oxygenDepletionRate;
+			if (oxygenLevel < 0) oxygenLevel = 0;
+		}
+		else {
+			oxygenLevel += 0.5f; // Slowly recover when above water
+			if (oxygenLevel > 100) oxygenLevel = 100;
+		}
+
+		// Check air bubble collection. Only the bubbles around the player's cell are
+		// looked at; collected ones are swap-removed from airBubbles (highest index
+		// first, so the pending ones don't move).
+		const float bubbleRadius = cellSize / 2;
+		hits.clear();
+		bubbleIndex.ForEachNear(playerX, playerY, bubbleRadius, [&](int i) {
+			float dx = playerX - airBubbles[i].x, dy = playerY - airBubbles[i].y;
+			if (dx * dx + dy * dy < bubbleRadius * bubbleRadius) hits.push_back(i);
+		});
+		if (hits.size() > 1) std::sort(hits.begin(), hits.end(), [](int a, int b) { return a > b; });
+		for (int i : hits) {
+			oxygenLevel = std::min(100.0f, oxygenLevel + 50.0f);
+			bubbleIndex.Remove(i);
+			int last = (int)airBubbles.size() - 1;
+			if (i != last) {
+				airBubbles[i] = airBubbles[last];
+				bubbleIndex.Renumber(last, i);
+			}
+			airBubbles.pop_back();
+		}
+
+		// Check drain switch activation (radius is one cell); switched-on drains stay
+		// for drawing but leave the index
+		hits.clear();
+		drainIndex.ForEachNear(playerX, playerY, (float)cellSize, [&](int i) {
+			const DrainSwitch& drain = drainSwitches[i];
+			float dx = playerX - drain.x, dy = playerY - drain.y;
+			if (dx * dx + dy * dy < drain.activationRadius * drain.activationRadius) hits.push_back(i);
+		});
+		for (int i : hits) {
+			drainSwitches[i].activated = true;
+			drainIndex.Remove(i);
+			activeDrains++;
+		}
+	}
+
+	bool IsGameOver() const {
+		return oxygenLevel <= 0;
+	}
+
+	float GetWaterPercentage() const {
+		return flood.Percentage();
+	}
+};
+
+class Player2D {
+public:
+	float x, y;
+	float prevX, prevY;  // before the last tick, for drawing between ticks
+	float speed = 2.0f;
+	float size = 12.0f;
+	int cellSize = 20;
+
+	Player2D() {
+		Reset(MazeConfig());
+	}
+
+	void Reset(const MazeConfig& config) { // This is for the new game.
+		cellSize = config.cellSize;
+		speed = cellSize * 0.1f;
+		size = cellSize * 0.6f;
+		x = prevX = cellSize / 2;
+		y = prevY = cellSize / 2;
+	}
+
+	float DrawX(float alpha) const { return prevX + (x - prevX) * alpha; }
+	float DrawY(float alpha) const { return prevY + (y - prevY) * alpha; }
+
+	template <class Grid>
+	void Update(uint8_t input, const Grid& grid) {
+		prevX = x;
+		prevY = y;
+		float dx = 0;
+		float dy = 0;
+
+		// Movement input
+		if (input & INPUT_UP) dy -= speed;
+		if (input & INPUT_DOWN) dy += speed;
+		if (input & INPUT_LEFT) dx -= speed;
+		if (input & INPUT_RIGHT) dx += speed;
+
+		// Wall collision, sliding along walls; substepped if the speed ever exceeds a quarter cell
+		MoveCircle(grid, cellSize, x, y, size / 2, dx, dy, cellSize * 0.25f);
+	}
+
+	template <class Grid>
+	bool CanMoveTo(float newX, float newY, const Grid& grid) const {
+		return CircleFits(grid, cellSize, newX, newY, size / 2);
+	}
+
+	template <class Grid>
+	bool HasReachedExit(const Grid& grid) const {
+		float exitX = (grid.cols - 0.5f) * cellSize;
+		float exitY = (grid.rows - 0.5f) * cellSize;
+		float dist = sqrt(pow(x - exitX, 2) + pow(y - exitY, 2));
+		return dist < cellSize / 2;
+	}
+};
+
+// Steers a Player2D from cell centre to cell centre along the distance field.
+// Used for auto-solve in the game and as a bot in headless.cpp.
+class SolverBot {
+public:
+	int targetX = 0, targetY = 0;
+
+	// Start from whatever cell the player is in now
+	void Reset(const Player2D& p) {
+		targetX = (int)(p.x / p.cellSize);
+		targetY = (int)(p.y / p.cellSize);
+	}
+
+	uint8_t NextInput(const Player2D& p, const DistanceField& field) {
+		const int cellSize = p.cellSize;
+		float cx = targetX * cellSize + cellSize / 2.0f;
+		float cy = targetY * cellSize + cellSize / 2.0f;
+
+		if (fabs(p.x - cx) < 0.5f && fabs(p.y - cy) < 0.5f) {
+			int side = field.NextStep(targetX, targetY);
+			if (side >= 0) {
+				targetX += sideDX[side];
+				targetY += sideDY[side];
+				cx = targetX * cellSize + cellSize / 2.0f;
+				cy = targetY * cellSize + cellSize / 2.0f;
+			}
+		}
+
+		uint8_t input = 0;
+		if (cy < p.y - 0.5f) input |= INPUT_UP;
+		if (cy > p.y + 0.5f) input |= INPUT_DOWN;
+		if (cx < p.x - 0.5f) input |= INPUT_LEFT;
+		if (cx > p.x + 0.5f) input |= INPUT_RIGHT;
+		return input;
+	}
+};
+
+enum RivalState : uint8_t {
+	RIVAL_RACING,
+	RIVAL_ESCAPED,
+	RIVAL_DROWNED,
+};
+
+// AI rivals racing the player to the exit, each with its own oxygen. Kept as
+// structure-of-arrays (positions live in a BodyBatch) and updated in chunks on
+// the thread pool. They steer like SolverBot along the exit field, only each
+// aims for its own spot inside every cell so a few hundred don't stack up, and
+// they move at their own speed. They only read the water: bubbles and drains
+// are left for the player.
+class RivalSwarm {
+public:
+	static const int CHUNK = 256;   // rivals per pool item
+
+	int count = 0;
+	int cellSize = 20;
+	BodyBatch bodies;
+	std::vector<float> prevX, prevY; // positions before the last tick, for drawing
+	std::vector<int> target;        // cell each rival is heading for
+	std::vector<float> offsetX, offsetY; // its spot inside a cell, from the centre
+	std::vector<float> speed;
+	std::vector<float> oxygen;
+	std::vector<uint8_t> state;     // RivalState
+	int racing = 0, escaped = 0, drowned = 0;
+
+	void Reset(const MazeConfig& config, int n, Rng& rng) {
+		count = n;
+		cellSize = config.cellSize;
+		bodies.Clear();
+		target.assign(n, 0);
+		offsetX.resize(n);
+		offsetY.resize(n);
+		speed.resize(n);
+		oxygen.assign(n, 100.0f);
+		state.assign(n, RIVAL_RACING);
+		racing = n;
+		escaped = drowned = 0;
+
+		// Radius 0.2 cells and spots up to 0.25 cells off centre still clear every wall
+		const float playerSpeed = cellSize * 0.1f; // as Player2D::Reset
+		for (int i = 0; i < n; i++) {
+			offsetX[i] = ((int)rng.Below(51) - 25) * 0.01f * cellSize;
+			offsetY[i] = ((int)rng.Below(51) - 25) * 0.01f * cellSize;
+			speed[i] = playerSpeed * (0.6f + rng.Below(41) * 0.01f);
+			bodies.Add(cellSize / 2.0f + offsetX[i], cellSize / 2.0f + offsetY[i], cellSize * 0.2f);
+		}
+		prevX = bodies.x;
+		prevY = bodies.y;
+	}
+
+	template <class Grid>
+	void Update(const Grid& grid, const DistanceField& field, const WaterSystem& water, int threads) {
+		const int chunks = (count + CHUNK - 1) / CHUNK;
+		ParallelFor(chunks, threads, [&](int chunk, int) {
+			int end = std::min(count, (chunk + 1) * CHUNK);
+			std::copy(bodies.x.begin() + chunk * CHUNK, bodies.x.begin() + end, prevX.begin() + chunk * CHUNK);
+			std::copy(bodies.y.begin() + chunk * CHUNK, bodies.y.begin() + end, prevY.begin() + chunk * CHUNK);
+			for (int i = chunk * CHUNK; i < end; i++) {
+				if (state[i] == RIVAL_RACING) Step(grid, field, water, i);
+			}
+		});
+
+		racing = escaped = drowned = 0;
+		for (int i = 0; i < count; i++) {
+			racing += state[i] == RIVAL_RACING;
+			escaped += state[i] == RIVAL_ESCAPED;
+			drowned += state[i] == RIVAL_DROWNED;
+		}
+	}
+
+private:
+	template <class Grid>
+	void Step(const Grid& grid, const DistanceField& field, const WaterSystem& water, int i) {
+		float& x = bodies.x[i];
+		float& y = bodies.y[i];
+		int tx = target[i] % grid.cols, ty = target[i] / grid.cols;
+		float goalX = (tx + 0.5f) * cellSize + offsetX[i];
+		float goalY = (ty + 0.5f) * cellSize + offsetY[i];
+
+		if (fabs(x - goalX) < 0.01f && fabs(y - goalY) < 0.01f) {
+			int side = field.NextStep(tx, ty);
+			if (side < 0) {
+				if (target[i] == field.exitCell) state[i] = RIVAL_ESCAPED;
+				return;
+			}
+			tx += sideDX[side];
+			ty += sideDY[side];
+			target[i] = tx + ty * grid.cols;
+			goalX += sideDX[side] * cellSize;
+			goalY += sideDY[side] * cellSize;
+		}
+
+		float dx = std::min(std::max(goalX - x, -speed[i]), speed[i]);
+		float dy = std::min(std::max(goalY - y, -speed[i]), speed[i]);
+		MoveCircle(grid, cellSize, x, y, bodies.radius[i], dx, dy, cellSize * 0.25f);
+
+		// Same oxygen rules as the player in WaterSystem::Update, minus the bubbles
+		int gridX = std::min(std::max((int)(x / cellSize), 0), water.flood.cols - 1);
+		int gridY = std::min(std::max((int)(y / cellSize), 0), water.flood.rows - 1);
+		if (y > (gridY + water.flood.Surface(gridX, gridY)) * cellSize) {
+			oxygen[i] -= water.oxygenDepletionRate;
+			if (oxygen[i] <= 0) {
+				oxygen[i] = 0;
+				state[i] = RIVAL_DROWNED;
+			}
+		}
+		else {
+			oxygen[i] = std::min(100.0f, oxygen[i] + 0.5f);
+		}
+	}
+};
+
+// A generated maze plus its bubbles and drains, checked for survivability.
+// MazePicker builds a batch of these in parallel and keeps the first winnable one.
+class MazeCandidate {
+public:
+	MazeGrid grid;
+	std::unique_ptr<MazeGenerator> generator;
+	WaterSystem water;
+	DistanceField solver;
+	SurvivalAnalysis analysis;
+	SurvivalReport report;
+	std::vector<int> bubbleCells, drainCells;
+
+	void Build(const MazeConfig& config, MazeAlgorithm algorithm, uint64_t seed) {
+		if (grid.cols != config.width || grid.rows != config.height) {
+			grid.Resize(config.width, config.height);
+		}
+		if (!generator || generator->Algorithm() != algorithm) {
+			generator = MakeMazeGenerator(algorithm);
+		}
+		// Separate streams, so changing a generator doesn't move the bubbles
+		Rng mazeRng(seed, RNG_MAZE);
+		generator->Generate(grid, mazeRng);
+		Rng waterRng(seed, RNG_WATER);
+		water.Reset(config, waterRng);
+
+		Player2D player;
+		player.Reset(config);
+		analysis.params.ticksPerCell = config.cellSize / player.speed;
+		analysis.params.fillTicks = config.cellSize / water.riseSpeed;
+		analysis.params.oxygenDrain = water.oxygenDepletionRate;
+
+		bubbleCells.clear();
+		for (auto& bubble : water.airBubbles) bubbleCells.push_back(CellAt(bubble.x, bubble.y));
+		drainCells.clear();
+		for (auto& drain : water.drainSwitches) drainCells.push_back(CellAt(drain.x, drain.y));
+
+		WithMazeView(grid, [&](auto view) {
+			solver.Build(view, grid.cols - 1, grid.rows - 1);
+			report = analysis.Run(view, solver, bubbleCells, drainCells);
+		});
+	}
+
+	int CellAt(float x, float y) const {
+		int cellSize = water.cellSize;
+		int cx = std::min(std::max((int)(x / cellSize), 0), grid.cols - 1);
+		int cy = std::min(std::max((int)(y / cellSize), 0), grid.rows - 1);
+		return cx + cy * grid.cols;
+	}
+};
+
+// The maze a game is played on, with its bubbles, drains and solver, ready to
+// hand to FloodGame::Start()
+class PreparedMaze {
+public:
+	MazeConfig config;
+	MazeAlgorithm algorithm = MazeAlgorithm::Backtracker;
+	uint64_t seed = 0;      // the game seed
+	uint64_t mazeSeed = 0;  // seed of the candidate picked
+	int rejected = 0;       // unwinnable candidates passed over
+	MazeGrid grid;
+	WaterSystem water;
+	DistanceField solver;
+};
+
+// Picks the maze for a game seed. Candidate seeds are one sequence drawn from
+// the game seed, and the first winnable candidate in that sequence is played.
+// They're built and checked a batch at a time, one per thread, but the pick
+// only depends on the seed: not on the thread count, nor on which thread
+// finishes first. Keeps its candidates between picks; one picker per thread.
+class MazePicker {
+public:
+	static constexpr int MAX_TRIES = 64; // after this many unwinnable mazes, play one anyway
+
+	std::vector<MazeCandidate> candidates;
+	std::vector<uint64_t> seeds;
+
+	void Pick(const MazeConfig& config, MazeAlgorithm algorithm, uint64_t seed, int threads, PreparedMaze& out) {
+		const int batch = std::max(1, std::min(threads, MAX_TRIES));
+		if ((int)candidates.size() < batch) candidates.resize(batch);
+		seeds.resize(batch);
+
+		Rng seedRng(seed, RNG_CANDIDATES);
+		int chosen = -1;
+		out.rejected = 0;
+		for (int tried = 0; chosen < 0 && tried < MAX_TRIES; tried += batch) {
+			int count = std::min(batch, MAX_TRIES - tried);
+			for (int i = 0; i < count; i++) seeds[i] = seedRng.Next();
+			ParallelFor(count, threads, [&](int i, int) { candidates[i].Build(config, algorithm, seeds[i]); });
+			for (int i = 0; i < count && chosen < 0; i++) {
+				if (candidates[i].report.Winnable()) chosen = i;
+				else out.rejected++;
+			}
+		}
+		if (chosen < 0) {
+			// Nothing winnable: play the first candidate anyway
+			seeds[0] = Rng(seed, RNG_CANDIDATES).Next();
+			candidates[0].Build(config, algorithm, seeds[0]);
+			chosen = 0;
+		}
+
+		MazeCandidate& picked = candidates[chosen];
+		out.config = config;
+		out.algorithm = algorithm;
+		out.seed = seed;
+		out.mazeSeed = seeds[chosen];
+		out.grid = picked.grid;
+		std::swap(out.water, picked.water);
+		std::swap(out.solver, picked.solver);
+	}
+};
+
+// One complete Flood Escape run: maze, player and water, advanced one fixed tick at a time.
+// main() feeds it keyboard input, headless.cpp feeds it a bot. Everything random
+// comes from the seed given to NewGame(), and every run is recorded in `replay`.
+class FloodGame {
+public:
+	MazeConfig config;
+	MazeAlgorithm algorithm = MazeAlgorithm::Backtracker;
+	MazeGrid grid;
+	Player2D player;
+	WaterSystem waterSystem;
+	DistanceField solver;  // rebuilt for every maze
+	float gameTimer = 0;
+	bool hasWon = false;
+	int ticks = 0;
+	int mazeVersion = 0;    // bumped for every new maze, so renderers know to redraw
+	uint64_t seed = 0;      // this game's seed
+	int rivalCount = 0;     // AI rivals racing the player, 0 for a solo game
+	RivalSwarm rivals;
+
+	int threads = DefaultThreadCount();
+	MazePicker picker;
+	PreparedMaze next;      // scratch for NewGame()
+	int rejectedMazes = 0;  // total over all games, for headless stats
+	Replay replay;          // the run so far
+	MazePack pack;          // levels to play instead of generated mazes, see OpenPack()
+	int packLevel = -1;     // level being played, -1 for a generated maze
+
+	FloodGame() : grid(config.width, config.height) {}
+
+	void NewGame(uint64_t gameSeed) {
+		picker.Pick(config, algorithm, gameSeed, threads, next);
+		Start(next);
+	}
+
+	// Plays a maze picked ahead of time, maybe on another thread. Its walls,
+	// water and solver are swapped in, so `maze` gets this game's old ones.
+	void Start(PreparedMaze& maze) {
+		config = maze.config;
+		algorithm = maze.algorithm;
+		seed = maze.seed;
+		packLevel = -1;
+		rejectedMazes += maze.rejected;
+		std::swap(grid, maze.grid);
+		std::swap(waterSystem, maze.water);
+		std::swap(solver, maze.solver);
+		mazeVersion++;
+		player.Reset(config);
+		Rng rivalRng(maze.mazeSeed, RNG_RIVALS);
+		rivals.Reset(config, rivalCount, rivalRng);
+		gameTimer = 0;
+		hasWon = false;
+		ticks = 0;
+		replay.Begin(ReplayMode::Flood, config, algorithm, rivalCount, seed);
+	}
+
+	bool OpenPack(const std::string& file) {
+		packLevel = -1;
+		// The grid may still be reading the old pack's mapping, which Open() drops
+		grid.Own();
+		return pack.Open(file);
+	}
+
+	// Plays a level of the open pack. The grid reads the walls straight out of
+	// the mapped file; the level keeps its own size, cellSize stays as it is.
+	bool NewPackGame(int level) {
+		if (!pack.LevelValid(level)) return false;
+		const MazePackLevel& info = pack.Level(level);
+		config.width = (int)info.width;
+		config.height = (int)info.height;
+		grid.Borrow(config.width, config.height, pack.Walls(level));
+		waterSystem.Reset(config, pack.Bubbles(level), (int)info.bubbleCount, pack.Drains(level), (int)info.drainCount);
+		WithMazeView(grid, [&](auto view) { solver.Build(view, grid.cols - 1, grid.rows - 1); });
+
+		seed = info.seed;
+		packLevel = level;
+		mazeVersion++;
+		player.Reset(config);
+		Rng rivalRng(seed + level, RNG_RIVALS); // hand made levels all have seed 0
+		rivals.Reset(config, rivalCount, rivalRng);
+		gameTimer = 0;
+		hasWon = false;
+		ticks = 0;
+		replay.Begin(ReplayMode::Flood, config, algorithm, rivalCount, seed);
+		replay.packPath = pack.path;
+		replay.packLevel = level;
+		return true;
+	}
+
+	// Sets up the game a replay was recorded from; feed it replay.InputAt(ticks).
+	// False if it was played on a pack level that can't be opened any more.
+	bool NewGame(const Replay& from) {
+		config = from.config;
+		algorithm = from.algorithm;
+		rivalCount = from.rivalCount;
+		if (from.packPath.empty()) {
+			NewGame(from.seed);
+			return true;
+		}
+		if (pack.path != from.packPath && !OpenPack(from.packPath)) return false;
+		return NewPackGame(from.packLevel);
+	}
+
+	// Player, oxygen and water, for the replay checkpoints
+	uint32_t StateHash() const {
+		uint32_t h = 2166136261u;
+		h = HashBytes(h, &player.x, sizeof(float));
+		h = HashBytes(h, &player.y, sizeof(float));
+		h = HashBytes(h, &waterSystem.oxygenLevel, sizeof(float));
+		h = HashBytes(h, &waterSystem.flood.volume, sizeof(waterSystem.flood.volume));
+		h = HashBytes(h, &rivals.escaped, sizeof(int));
+		h = HashBytes(h, &rivals.drowned, sizeof(int));
+		return h;
+	}
+
+	bool IsOver() const {
+		return hasWon || waterSystem.IsGameOver();
+	}
+
+	void Step(uint8_t input) {
+		if (IsOver()) return;
+		replay.inputs.push_back(input);
+
+		// Common maze sizes get the fixed-size view so wall lookups are shifts and masks
+		WithMazeView(grid, [&](auto view) {
+			{
+				ProfileScope zone(PROFILE_PLAYER);
+				player.Update(input, view);
+				hasWon = player.HasReachedExit(view);
+			}
+			{
+				ProfileScope zone(PROFILE_WATER);
+				waterSystem.Update(view, player.x, player.y, TICK_DT);
+			}
+			ProfileScope zone(PROFILE_RIVALS);
+			rivals.Update(view, solver, waterSystem, threads);
+		});
+
+		ticks++;
+		gameTimer = ticks * TICK_DT;
+		if (ticks % TICK_RATE == 0) replay.checkpoints.push_back(StateHash());
+	}
+};
@@ -0,0 +1,150 @@
+#pragma once
+// Distance-to-exit field. One pass from the exit per maze; after that every cell
+// knows how far the exit is and which side to leave through, so hints, the
+// auto-solver and maze validation are all O(1) lookups. No raylib in here.
+#include <vector>
+#include <cstdint>
+#include "maze.h"
+#include "mazegen.h"
+
+class DistanceField {
+public:
+	static constexpr uint32_t UNREACHABLE = ~0u;
+
+	int cols = 0;
+	int rows = 0;
+	int exitCell = 0;
+	int reached = 0;              // cells connected to the exit
+	std::vector<uint32_t> dist;   // steps to the exit, UNREACHABLE if walled off
+	std::vector<uint8_t> toward;  // WallSide to leave through to get one step closer
+	struct WalkEntry {
+		uint32_t cell;
+		uint32_t step;  // distance << 2 | side back towards the exit
+	};
+	std::vector<WalkEntry> stack;
+	std::vector<int> queue;
+
+	template <class Grid>
+	void Build(const Grid& grid, int exitX, int exitY) {
+		cols = grid.cols;
+		rows = grid.rows;
+		exitCell = exitX + exitY * cols;
+		dist.assign(cols * rows, UNREACHABLE);
+		toward.resize(cols * rows);
+		if (!WalkTree(grid)) {
+			dist.assign(cols * rows, UNREACHABLE);
+			Bfs(grid, exitCell, 1);
+		}
+	}
+
+	// Distance to the nearest cell of a whole row instead of a single exit
+	// (how far the flood has to travel from the bottom row, see survive.h)
+	template <class Grid>
+	void BuildFromRow(const Grid& grid, int row) {
+		cols = grid.cols;
+		rows = grid.rows;
+		exitCell = row * cols;
+		dist.assign(cols * rows, UNREACHABLE);
+		toward.resize(cols * rows);
+		Bfs(grid, exitCell, cols);
+	}
+
+	// Every generator makes a perfect maze, so the only open neighbour already
+	// visited is the one we came from and no visited checks are needed: a plain
+	// DFS gives the same distances as BFS. The pushes are branchless (slot
+	// always written, only counted when the side is open) since the wall bits
+	// are coin flips. Returns false when the maze turns out to have a loop.
+	template <class Grid>
+	bool WalkTree(const Grid& grid) {
+		const int cells = cols * rows;
+		stack.resize(cells + 4);
+		int sp = 0;
+		stack[sp++] = { (uint32_t)exitCell, WALL_BOTTOM };
+		reached = 0;
+
+		while (sp > 0) {
+			WalkEntry e = stack[--sp];
+			int cell = e.cell;
+			int back = e.step & 3;
+			uint32_t d = e.step >> 2;
+			dist[cell] = d;
+			toward[cell] = back;
+			if (++reached > cells) return false;
+
+			int y = cell / cols, x = cell - y * cols;
+			int bits = grid.WallBits(x, y);
+			unsigned open = (!(bits & 2)) << WALL_BOTTOM | (!(bits & 1)) << WALL_RIGHT
+				| (x > 0 && !grid.RightWall(x - 1, y)) << WALL_LEFT
+				| (y > 0 && !grid.BottomWall(x, y - 1)) << WALL_TOP;
+			if (cell != exitCell) open &= ~(1u << back);
+
+			uint32_t next = (d + 1) << 2;
+			stack[sp] = { (uint32_t)(cell - cols), next | WALL_BOTTOM };
+			sp += open & 1;
+			stack[sp] = { (uint32_t)(cell + cols), next | WALL_TOP };
+			sp += (open >> WALL_BOTTOM) & 1;
+			stack[sp] = { (uint32_t)(cell - 1), next | WALL_RIGHT };
+			sp += (open >> WALL_LEFT) & 1;
+			stack[sp] = { (uint32_t)(cell + 1), next | WALL_LEFT };
+			sp += (open >> WALL_RIGHT) & 1;
+			if (sp > cells) return false;
+		}
+		return true;
+	}
+
+	// General BFS for mazes with loops, from `count` source cells starting at `first`
+	template <class Grid>
+	void Bfs(const Grid& grid, int first, int count) {
+		queue.resize(cols * rows);
+		int head = 0, tail = 0;
+		for (int cell = first; cell < first + count; cell++) {
+			dist[cell] = 0;
+			toward[cell] = WALL_BOTTOM;
+			queue[tail++] = cell;
+		}
+
+		// Each neighbour we discover steps back into `cell`, hence the opposite side
+		while (head < tail) {
+			int cell = queue[head++];
+			int y = cell / cols, x = cell - y * cols;
+			uint32_t d = dist[cell] + 1;
+			int bits = grid.WallBits(x, y);
+
+			if (x + 1 < cols && !(bits & 1) && dist[cell + 1] == UNREACHABLE) {
+				dist[cell + 1] = d;
+				toward[cell + 1] = WALL_LEFT;
+				queue[tail++] = cell + 1;
+			}
+			if (y + 1 < rows && !(bits & 2) && dist[cell + cols] == UNREACHABLE) {
+				dist[cell + cols] = d;
+				toward[cell + cols] = WALL_TOP;
+				queue[tail++] = cell + cols;
+			}
+			if (x > 0 && !grid.RightWall(x - 1, y) && dist[cell - 1] == UNREACHABLE) {
+				dist[cell - 1] = d;
+				toward[cell - 1] = WALL_RIGHT;
+				queue[tail++] = cell - 1;
+			}
+			if (y > 0 && !grid.BottomWall(x, y - 1) && dist[cell - cols] == UNREACHABLE) {
+				dist[cell - cols] = d;
+				toward[cell - cols] = WALL_BOTTOM;
+				queue[tail++] = cell - cols;
+			}
+		}
+		reached = tail;
+	}
+
+	bool Ready() const { return !dist.empty(); }
+
+	// Every cell can reach the exit (a generator bug would show up here)
+	bool Connected() const { return reached == cols * rows; }
+
+	uint32_t Distance(int x, int y) const { return dist[x + y * cols]; }
+
+	// Side to move through from (x, y) towards the exit, -1 at the exit or when cut off
+	int NextStep(int x, int y) const {
+		uint32_t d = dist[x + y * cols];
+		if (d == 0 || d == UNREACHABLE) return -1;
+		return toward[x + y * cols];
+	}
+};
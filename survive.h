@@ -0,0 +1,121 @@
+#pragma once
+// Survivability check for a freshly generated maze: compares when the flood
+// reaches each cell with when the player can get there, so FloodGame can throw
+// away mazes that can't be finished before the oxygen runs out. No raylib in here.
+#include <vector>
+#include <algorithm>
+#include "maze.h"
+#include "solver.h"
+
+// Game rules the check needs, in ticks and oxygen units (FloodGame fills these in)
+struct SurvivalParams {
+	float ticksPerCell = 10;    // player crossing one cell
+	float fillTicks = 67;       // flood filling one cell
+	float oxygenDrain = 0.15f;  // per tick underwater
+	float oxygenRecover = 0.5f; // per tick above water, as in WaterSystem::Update
+	float bubbleOxygen = 50;    // same
+	float drainedFlow = 0.3f;   // flood speed once one drain is on, same
+};
+
+struct SurvivalReport {
+	bool exitInTime = false;  // direct route to the exit never runs out of oxygen
+	int drainInTime = -1;     // a drain the route start -> drain -> exit works through, or -1
+
+	bool Winnable() const {
+		return exitInTime || drainInTime >= 0;
+	}
+};
+
+// Walks shortest routes the way the player would: start to exit, or start to a
+// drain and from there to the exit. The flood keeps its full speed until the
+// route switches the drain on and goes at drainedFlow after it; bubbles count
+// when the route goes through their cell, once each. Drains the route passes on
+// the way and bubbles off it are left out, they could only help. Flood timing
+// is the distance from the bottom row times fillTicks, an estimate.
+class SurvivalAnalysis {
+public:
+	SurvivalParams params;
+	DistanceField fromStart;
+	DistanceField fromFloor;  // cells the flood has to fill before it gets here
+	BitSet bubbleCells;
+	std::vector<int> route;
+	std::vector<int> taken;   // bubbles picked up on the route being walked
+
+	template <class Grid>
+	SurvivalReport Run(const Grid& grid, const DistanceField& toExit,
+		const std::vector<int>& bubbles, const std::vector<int>& drains) {
+		fromStart.Build(grid, 0, 0);
+		fromFloor.BuildFromRow(grid, grid.rows - 1);
+		bubbleCells.Resize(grid.CellCount());
+		for (int cell : bubbles) bubbleCells.Set(cell);
+
+		SurvivalReport report;
+		route.clear();
+		AppendToExit(grid, toExit, 0);
+		report.exitInTime = route.back() == toExit.exitCell && LowestOxygen(-1) > 0;
+		if (report.exitInTime) return report;
+
+		// Start to each drain (walk the start field back from the drain, then
+		// reverse), and on to the exit from there
+		for (size_t d = 0; d < drains.size() && report.drainInTime < 0; d++) {
+			route.clear();
+			for (int c = drains[d];;) {
+				route.push_back(c);
+				int side = fromStart.NextStep(c % grid.cols, c / grid.cols);
+				if (side < 0) break;
+				c += sideDX[side] + sideDY[side] * grid.cols;
+			}
+			if (route.back() != 0) continue; // start not reachable from there
+			std::reverse(route.begin(), route.end());
+			int drainAt = (int)route.size() - 1;
+			route.pop_back();
+			AppendToExit(grid, toExit, drains[d]);
+			if (route.back() == toExit.exitCell && LowestOxygen(drainAt) > 0) report.drainInTime = (int)d;
+		}
+		return report;
+	}
+
+	// Follows the exit field from `cell` onto the end of the route
+	template <class Grid>
+	void AppendToExit(const Grid& grid, const DistanceField& toExit, int cell) {
+		route.push_back(cell);
+		int x = cell % grid.cols, y = cell / grid.cols;
+		for (int side = toExit.NextStep(x, y); side >= 0; side = toExit.NextStep(x, y)) {
+			x += sideDX[side];
+			y += sideDY[side];
+			route.push_back(x + y * grid.cols);
+		}
+	}
+
+	// When the water gets to the middle of a cell, where the player crosses it,
+	// in ticks of flood at full speed
+	float FloodTick(int cell) const {
+		return (fromFloor.dist[cell] + 0.5f) * params.fillTicks;
+	}
+
+	// Oxygen low point walking `route` from a full tank, grabbing bubbles on the
+	// way. The drain at route[drainAt] is switched on there; -1 for none.
+	float LowestOxygen(int drainAt) {
+		float oxygen = 100, lowest = 100;
+		taken.clear();
+		for (size_t i = 0; i < route.size(); i++) {
+			int cell = route[i];
+			// How far the flood has got by now, in full speed ticks
+			float flood = i * params.ticksPerCell;
+			if (drainAt >= 0 && (int)i > drainAt) {
+				float switchedOn = drainAt * params.ticksPerCell;
+				flood = switchedOn + (flood - switchedOn) * params.drainedFlow;
+			}
+			if (flood >= FloodTick(cell)) oxygen -= params.oxygenDrain * params.ticksPerCell;
+			else oxygen = std::min(100.0f, oxygen + params.oxygenRecover * params.ticksPerCell);
+			lowest = std::min(lowest, oxygen);
+			if (bubbleCells.Test(cell)) {
+				oxygen = std::min(100.0f, oxygen + params.bubbleOxygen);
+				bubbleCells.Clear(cell);
+				taken.push_back(cell);
+			}
+		}
+		for (int cell : taken) bubbleCells.Set(cell);
+		return lowest;
+	}
+};